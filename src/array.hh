@@ -11,7 +11,9 @@
 
 #include "memory.hh"
 #include "exception.hh"
+#include "shape.hh"
 #include "array_iterator.hh"
+#include "numa.hh"
 #include <vector>
 
 #include <iostream>
@@ -19,6 +21,9 @@
 
 namespace Linalg {
 
+/* Forward declaration. */
+template <class Derived> class ArrayExpr;
+
 
 /**
  * This class represents an N-dimensional array.
@@ -52,33 +57,35 @@ public:
     /** Constructor. */
     Values(Array<Scalar> &array): _array(array) { /* Pass... */ }
 
-    /** Assignment. */
+    /**
+     * Assignment, @c other is broadcast to the shape of the array (see @c broadcast).
+     */
     Values &operator= (const Array<Scalar> &other)
     {
-      // Check array dimension:
-      LINALG_SHAPE_ASSERT(_array.ndim() == other.ndim());
-      for (size_t i=0; i<_array.ndim(); i++) {
-        LINALG_SHAPE_ASSERT(_array.shape(i) == other.shape(i));
-      }
+      // Broadcast other to the shape of _array (throws ShapeError if not possible):
+      Shape strides = __broadcast_strides(other.shape(), other.strides(), _array.shape());
 
-      // Iterate over all values of _array and array and assign other -> _array:
-      iterator a_iter = _array.begin();
-      const_iterator b_iter = other.const_begin();
-      for (; a_iter != _array.end(); a_iter++, b_iter++) {
-        *a_iter = *b_iter;
-      }
+      // Copy all values of other -> _array, as a single flat copy if both are dense:
+      __copy(_array.shape(), _array.ptr(), _array.strides(), other.ptr(), strides);
 
       // Done..
       return *this;
     }
 
+    /**
+     * Assignment of a lazy expression, evaluated in a single pass (see @c ArrayExpr).
+     */
+    template <class Expr>
+    Values &operator= (const ArrayExpr<Expr> &expr)
+    {
+      __evaluate(_array.shape(), _array.ptr(), _array.strides(), expr);
+      return *this;
+    }
+
     /** Assignment. */
     Values &operator= (const Scalar &value) {
-      // Iterate over all values of _array assign value -> _array:
-      iterator a_iter = _array.begin();
-      for (; a_iter != _array.end(); a_iter++) {
-        *a_iter = value;
-      }
+      // Assign value -> _array:
+      __fill(_array.shape(), _array.ptr(), _array.strides(), value);
 
       // Done..
       return *this;
@@ -91,10 +98,10 @@ protected:
   size_t _offset;
 
   /** Holds the dimensions of the array. */
-  std::vector<size_t> _shape;
+  Shape _shape;
 
   /** Holds the strides of the array. */
-  std::vector<size_t> _strides;
+  Shape _strides;
 
   /**
    * Holds a value-reference instance to the data.
@@ -106,8 +113,7 @@ protected:
   /**
    * Hidden, full constructor from pointer.
    */
-  Array(Scalar *data, size_t offset, const std::vector<size_t> &shape,
-        const std::vector<size_t> &strides, bool take_data)
+  Array(Scalar *data, size_t offset, const Shape &shape, const Shape &strides, bool take_data)
     : DataPtr<Scalar>(new DataMngr<Scalar>(data, take_data)), _offset(offset),
       _shape(shape), _strides(strides), _values(*this)
   {
@@ -119,8 +125,7 @@ public:
   /**
    * Full constructor from data.
    */
-  Array(const DataPtr<Scalar> &data, size_t offset, const std::vector<size_t> &shape,
-        const std::vector<size_t> &strides)
+  Array(const DataPtr<Scalar> &data, size_t offset, const Shape &shape, const Shape &strides)
     : DataPtr<Scalar>(data), _offset(offset), _shape(shape), _strides(strides),
       _values(*this)
   {
@@ -132,7 +137,7 @@ public:
    * Constructs uninitialized/empty array.
    */
   Array()
-    : DataPtr<Scalar>(), _offset(0), _shape(0), _strides(0), _values(*this)
+    : DataPtr<Scalar>(), _offset(0), _shape(), _strides(), _values(*this)
   {
     // Done..
   }
@@ -141,7 +146,7 @@ public:
   /**
    * Allocates a new (empty) array of the given shape.
    */
-  Array(const std::vector<size_t> &shape, bool rowmajor=true)
+  Array(const Shape &shape, bool rowmajor=true)
     : DataPtr<Scalar>(), _offset(0), _shape(shape), _strides(shape.size()), _values(*this)
   {
     // Check if dimension
@@ -151,28 +156,40 @@ public:
     // Determine size and create strides in column-major:
     size_t size = 1;
     if (rowmajor) {
-      std::vector<size_t>::reverse_iterator sh_iter = _shape.rbegin();
-      std::vector<size_t>::reverse_iterator st_iter = _strides.rbegin();
-      for(; sh_iter != _shape.rend(); sh_iter++, st_iter++) {
-        *st_iter = size;
-        size *= *sh_iter;
+      for (size_t i=_shape.size(); i>0; i--) {
+        _strides[i-1] = size;
+        size *= _shape[i-1];
       }
     } else {
-      std::vector<size_t>::iterator sh_iter = _shape.begin();
-      std::vector<size_t>::iterator st_iter = _strides.begin();
-      for(; sh_iter != _shape.end(); sh_iter++, st_iter++) {
-        *st_iter = size;
-        size *= *sh_iter;
+      for (size_t i=0; i<_shape.size(); i++) {
+        _strides[i] = size;
+        size *= _shape[i];
       }
     }
 
     // Allocate some data and assign it to this:
-    DataPtr<Scalar>::operator =(DataPtr<Scalar>(new DataMngr<Scalar>(size)));
+    DataPtr<Scalar>::operator =(DataPtr<Scalar>(DataMngr<Scalar>::allocate(size)));
+    NUMA::place(this->_mngr->ptr(), size*sizeof(Scalar));
 
     // Done...
   }
 
 
+  /**
+   * Allocates a new array and evaluates the given expression (see @c ArrayExpr) into it. The
+   * storage order is taken from the first operand of the expression.
+   */
+  template <class Expr>
+  Array(const ArrayExpr<Expr> &expr)
+    : DataPtr<Scalar>(), _offset(0), _shape(), _strides(), _values(*this)
+  {
+    LINALG_MEMSTATS_TAG("expression");
+    Array<Scalar> result(expr.shape(), expr.derived().isRowMajor());
+    __evaluate(result.shape(), result.ptr(), result.strides(), expr);
+    this->swap(result);
+  }
+
+
   /** Copy constructor. */
   Array(const Array<Scalar> &other)
     : DataPtr<Scalar>(other), _offset(other._offset), _shape(other._shape), _strides(other._strides),
@@ -182,6 +199,17 @@ public:
   }
 
 
+  /** Move constructor, leaves @c other as an empty array. */
+  Array(Array<Scalar> &&other) noexcept
+    : DataPtr<Scalar>(std::move(other)), _offset(other._offset),
+      _shape(other._shape), _strides(other._strides), _values(*this)
+  {
+    other._offset = 0;
+    other._shape.clear();
+    other._strides.clear();
+  }
+
+
   /**
    * Assignment operator.
    *
@@ -209,7 +237,36 @@ public:
 
 
   /**
-   * Creates a copy of this array.
+   * Move assignment, takes the data and shape of @c other leaving it as an empty array.
+   */
+  Array<Scalar> &operator= (Array<Scalar> &&other) noexcept
+  {
+    if (this != &other) {
+      DataPtr<Scalar>::operator =(std::move(other));
+      this->_shape   = other._shape; other._shape.clear();
+      this->_strides = other._strides; other._strides.clear();
+      this->_offset  = other._offset; other._offset = 0;
+    }
+
+    return *this;
+  }
+
+
+  /**
+   * Exchanges the data and shape of this array and @c other. The values are not touched.
+   */
+  inline void swap(Array<Scalar> &other) noexcept
+  {
+    DataPtr<Scalar>::swap(other);
+    std::swap(this->_offset, other._offset);
+    this->_shape.swap(other._shape);
+    this->_strides.swap(other._strides);
+  }
+
+
+  /**
+   * Creates a copy of this array with the given storage order. Conversions between row-major
+   * and column-major are performed by a blocked transpose (see @c __copy).
    */
   Array<Scalar> copy(bool rowmajor=true)
   {
@@ -231,7 +288,7 @@ public:
   /**
    * Returns the shape of the array.
    */
-  inline const std::vector<size_t> &shape() const
+  inline const Shape &shape() const
   {
     return _shape;
   }
@@ -258,7 +315,7 @@ public:
   /**
    * Returns the strides of the array.
    */
-  inline const std::vector<size_t> &strides() const
+  inline const Shape &strides() const
   {
     return _strides;
   }
@@ -293,7 +350,7 @@ public:
   /**
    * Returns the element at the given index.
    */
-  Scalar &at(const std::vector<size_t> &idxs)
+  Scalar &at(const Shape &idxs)
   {
     LINALG_SHAPE_ASSERT(idxs.size() == _strides.size());
 
@@ -309,7 +366,7 @@ public:
   /**
    * Returns the element at the given index-vector.
    */
-  const Scalar &at(const std::vector<size_t> &idxs) const
+  const Scalar &at(const Shape &idxs) const
   {
     LINALG_SHAPE_ASSERT(idxs.size() == _strides.size());
 
@@ -318,7 +375,7 @@ public:
       offset += idxs[i]*_strides[i];
     }
 
-    return this->_data->prt()[offset];
+    return this->_data[offset];
   }
 
 
@@ -327,9 +384,41 @@ public:
    */
   inline Array<Scalar> t() const
   {
-    return Array<Scalar>(*this, this->_offset,
-                         std::vector<size_t>(_shape.rbegin(), _shape.rend()),
-                         std::vector<size_t>(_strides.rbegin(), _strides.rend()));
+    return Array<Scalar>(*this, this->_offset, _shape.reversed(), _strides.reversed());
+  }
+
+
+  /**
+   * Returns a view of the array broadcast to the given shape (NumPy rules), without copying:
+   * The shapes are aligned at their last dimension, dimensions of size 1 and missing leading
+   * dimensions are repeated by a zero stride. E.g. a vector of dimension n broadcast to (m,n)
+   * is a matrix with m identical rows.
+   *
+   * The view must not be written to, as all repeated elements share the same memory.
+   *
+   * @throws ShapeError If the array can not be broadcast to @c shape.
+   */
+  inline Array<Scalar> broadcast(const Shape &shape) const
+  {
+    return Array<Scalar>(*this, _offset, shape, __broadcast_strides(_shape, _strides, shape));
+  }
+
+
+  /**
+   * Returns a view of the array with an additional dimension of size 1 inserted at @c axis.
+   * E.g. @c x.expand(1) of a vector is a single column, that broadcasts along the columns.
+   *
+   * @throws ShapeError If @c axis > ndim().
+   */
+  inline Array<Scalar> expand(size_t axis) const
+  {
+    LINALG_SHAPE_ASSERT(axis <= _shape.size());
+    Shape shape(_shape.size()+1), strides(_shape.size()+1);
+    for (size_t i=0, j=0; i<shape.size(); i++) {
+      if (i == axis) { shape[i] = 1; strides[i] = 0; }
+      else { shape[i] = _shape[j]; strides[i] = _strides[j]; j++; }
+    }
+    return Array<Scalar>(*this, _offset, shape, strides);
   }
 
 
@@ -369,7 +458,7 @@ public:
    * Returns an iterator over all elements of the array, pointing to the first element (0,0,...).
    */
   inline iterator begin() {
-    std::vector<size_t> idxs(this->_shape.size(), 0);
+    Shape idxs(this->_shape.size(), 0);
     return iterator(this, idxs);
   }
 
@@ -378,7 +467,7 @@ public:
    * of the array.
    */
   inline iterator end() {
-    std::vector<size_t> idxs(this->_shape.size(), 0);
+    Shape idxs(this->_shape.size(), 0);
     idxs.back() = this->shape().back();
     return iterator(this, idxs);
   }
@@ -387,7 +476,7 @@ public:
    * Returns a const iterator over all elements pointing to the first element (0,0,...).
    */
   inline const_iterator const_begin() const {
-    std::vector<size_t> idxs(this->_shape.size(), 0);
+    Shape idxs(this->_shape.size(), 0);
     return const_iterator(this, idxs);
   }
 
@@ -395,7 +484,7 @@ public:
    * Returns a const iterator over all elements of the array pointing right after the last element.
    */
   inline const_iterator const_end() const {
-    std::vector<size_t> idxs(this->_shape.size(), 0);
+    Shape idxs(this->_shape.size(), 0);
     idxs.back() = this->shape().back();
     return const_iterator(this, idxs);
   }
@@ -9,7 +9,8 @@
 #ifndef __LINALG_ARRAY_ITERATOR_HH__
 #define __LINALG_ARRAY_ITERATOR_HH__
 
-#include <vector>
+#include "shape.hh"
+#include "elementwise.hh"
 
 
 namespace Linalg {
@@ -17,199 +18,209 @@ namespace Linalg {
 template<class Scalar> class Array;
 
 
+/**
+ * Returns the linear position of the given index, where dimension 0 varies fastest.
+ */
+inline size_t __linear_index(const Shape &shape, const Shape &idx)
+{
+  size_t pos = 0;
+  for (size_t i=idx.size(); i>0; i--) {
+    pos = pos*shape[i-1] + idx[i-1];
+  }
+  return pos;
+}
+
+
+/**
+ * Initializes the index in the simplified dimensions of the given loop and the pointer for
+ * the given linear position.
+ */
+template <class Ptr>
+inline void __init_index(const StridedLoop<1> &loop, size_t pos, size_t *idx, Ptr &ptr)
+{
+  if (pos >= loop.size()) { return; }
+  for (size_t i=0; i<loop.ndim(); i++) {
+    idx[i] = pos % loop.shape(i); pos /= loop.shape(i);
+    ptr += idx[i]*loop.strides(0, i);
+  }
+}
+
+
+/**
+ * Advances the index and pointer of an iterator over the given loop by one element.
+ */
+template <class Ptr>
+inline void __advance(const StridedLoop<1> &loop, size_t &pos, size_t *idx, Ptr &ptr)
+{
+  if ((pos >= loop.size()) || (++pos == loop.size())) { return; }
+
+  for (size_t d=0; d<loop.ndim(); d++) {
+    ptr += loop.strides(0, d);
+    if (++idx[d] < loop.shape(d)) { return; }
+    ptr -= loop.shape(d)*loop.strides(0, d); idx[d] = 0;
+  }
+}
+
+
 /**
  * Implements iteration over complete array.
+ *
+ * The elements are visited in the order of the index, where dimension 0 varies fastest. The
+ * iterator merges contiguous dimensions of the array (see @c StridedLoop) and advances a raw
+ * pointer incrementally, hence dereferencing is free and the carry into the outer dimensions
+ * is only needed at the end of each contiguous block. Iterators are compared by their linear
+ * position.
+ *
+ * For loops over all elements, @c __copy, @c __fill and @c __transform are faster.
  */
 template <class Scalar>
 class ArrayIterator
 {
 private:
-  /** Holds the current index. */
-  std::vector<size_t> _current_idx;
-
-  /** Holds a reference to the array. */
-  Array<Scalar> *_array;
+  /** The simplified loop over the array. */
+  StridedLoop<1> _loop;
+  /** The index in the simplified dimensions. */
+  size_t _idx[LINALG_MAX_NDIM];
+  /** The linear position. */
+  size_t _pos;
+  /** Pointer to the current element. */
+  Scalar *_ptr;
 
 public:
   /** Default constructor. */
   ArrayIterator()
-    : _current_idx(0), _array(0)
+    : _loop(Shape(), 0, true), _pos(0), _ptr(0)
   {
     // Pass...
   }
 
   /**
-   * Constructor.
+   * Constructor, points to the element at the given index. An index with all elements 0 except
+   * the last one being the size of the last dimension points right after the last element.
    */
-  ArrayIterator(Array<Scalar> *array, const std::vector<size_t> &idx)
-    : _current_idx(idx), _array(array)
+  ArrayIterator(Array<Scalar> *array, const Shape &idx)
+    : _loop(array->shape(), &array->strides(), true),
+      _pos(__linear_index(array->shape(), idx)), _ptr(array->ptr())
   {
-    // Pass...
+    __init_index(_loop, _pos, _idx, _ptr);
   }
 
   /**
-   * Assignment operator.
+   * Increment operator, to shift the iterator to the next element.
    */
-  ArrayIterator<Scalar> &operator= (ArrayIterator<Scalar> &other)
+  inline ArrayIterator<Scalar> &operator++ ()
   {
-    _current_idx     = other._current_idx;
-    _array           = other._array;
-
+    __advance(_loop, _pos, _idx, _ptr);
     return *this;
   }
 
   /**
-   * Increment operator, to shif the iterator to the next element.
+   * Increment operator, to shift the iterator to the next element.
    */
-  ArrayIterator<Scalar> &operator++ (int)
+  inline ArrayIterator<Scalar> &operator++ (int)
   {
-    // Check if iterator is at the end:
-    if(_current_idx.back() == _array->shape().back())
-      return *this;
-
-    // Otherwise:
-    _current_idx[0]++;
-    for(size_t i=0; i<_array->ndim()-1; i++) {
-      if (_current_idx[i]==_array->shape(i)) {
-        _current_idx[i] = 0;
-        _current_idx[i+1]++;
-      }
-    }
-
-    // Done.
-    return *this;
+    return ++(*this);
   }
 
   /**
    * Iterator comparison.
    */
-  inline bool operator==(const ArrayIterator<Scalar> &other)
+  inline bool operator==(const ArrayIterator<Scalar> &other) const
   {
-    if (_current_idx.size() != other._current_idx.size())
-      return false;
-    for (size_t i=0; i<_current_idx.size(); i++) {
-      if (_current_idx[i] != other._current_idx[i])
-        return false;
-    }
-
-    return true;
+    return _pos == other._pos;
   }
 
   /**
    * Iterator comparison.
    */
-  bool operator!= (const ArrayIterator<Scalar> &other)
+  inline bool operator!= (const ArrayIterator<Scalar> &other) const
   {
-    return ! (*this == other);
+    return _pos != other._pos;
   }
 
   /**
    * Dereferencing the element addressed by the iterator.
    */
-  Scalar &operator*()
+  inline Scalar &operator*() const
   {
-    size_t offset = 0;
-    for (size_t i=0; i<_array->ndim(); i++) {
-      offset += _current_idx[i]*_array->strides(i);
-    }
-
-    return *(_array->ptr() + offset);
+    return *_ptr;
   }
 };
 
 
 
 /**
- * Const iterator class, to iterate over all elements of an array.
+ * Const iterator class, to iterate over all elements of an array, see @c ArrayIterator.
  */
 template <class Scalar>
 class ArrayConstIterator {
 private:
-  /** Holds the current index. */
-  std::vector<size_t> _current_idx;
-
-  /** Holds a reference to the array. */
-  const Array<Scalar> *_array;
+  /** The simplified loop over the array. */
+  StridedLoop<1> _loop;
+  /** The index in the simplified dimensions. */
+  size_t _idx[LINALG_MAX_NDIM];
+  /** The linear position. */
+  size_t _pos;
+  /** Pointer to the current element. */
+  const Scalar *_ptr;
 
 public:
   /** Default constructor. */
-  ArrayConstIterator() : _current_idx(0), _array(0) { /* Pass... */ }
+  ArrayConstIterator()
+    : _loop(Shape(), 0, true), _pos(0), _ptr(0)
+  {
+    // Pass...
+  }
 
   /**
    * Constructor.
    */
-  ArrayConstIterator(const Array<Scalar> *array, const std::vector<size_t> &idx)
-    : _current_idx(idx), _array(array)
+  ArrayConstIterator(const Array<Scalar> *array, const Shape &idx)
+    : _loop(array->shape(), &array->strides(), true),
+      _pos(__linear_index(array->shape(), idx)), _ptr(array->ptr())
   {
-    // Pass...
+    __init_index(_loop, _pos, _idx, _ptr);
   }
 
   /**
-   * Assignment operator.
+   * Increment operator, to shift the iterator to the next element.
    */
-  ArrayConstIterator &operator= (const ArrayConstIterator &other)
+  inline ArrayConstIterator &operator++ ()
   {
-    _current_idx     = other._current_idx;
-    _array           = other._array;
-
+    __advance(_loop, _pos, _idx, _ptr);
     return *this;
   }
 
   /**
-   * Increment operator, to shif the iterator to the next element.
+   * Increment operator, to shift the iterator to the next element.
    */
-  ArrayConstIterator &operator++ (int)
+  inline ArrayConstIterator &operator++ (int)
   {
-    // Check if iterator is at the end:
-    if(_current_idx.back() == _array->shape().back())
-      return *this;
-
-    // Otherwise:
-    _current_idx[0]++;
-    for(size_t i=0; i<_array->ndim()-1; i++) {
-      if (_current_idx[i]==_array->shape(i)) {
-        _current_idx[i] = 0;
-        _current_idx[i+1]++;
-      }
-    }
-
-    // Done.
-    return *this;
+    return ++(*this);
   }
 
   /**
    * Iterator comparison.
    */
-  inline bool operator==(const ArrayConstIterator &other)
+  inline bool operator==(const ArrayConstIterator &other) const
   {
-    if (_current_idx.size() != other._current_idx.size())
-      return false;
-    for (size_t i=0; i<_current_idx.size(); i++) {
-      if (_current_idx[i] != other._current_idx[i])
-        return false;
-    }
-
-    return true;
+    return _pos == other._pos;
   }
 
   /**
    * Iterator comparison.
    */
-  bool operator!= (const ArrayConstIterator &other)
+  inline bool operator!= (const ArrayConstIterator &other) const
   {
-    return ! (*this == other);
+    return _pos != other._pos;
   }
 
   /**
    * Dereferencing the element addressed by the iterator.
    */
-  const Scalar &operator*() const
+  inline const Scalar &operator*() const
   {
-    size_t offset = 0;
-    for (size_t i=0; i<_array->ndim(); i++) {
-      offset += _current_idx[i]*_array->strides(i);
-    }
-    return *(_array->ptr() + offset);
+    return *_ptr;
   }
 };
 
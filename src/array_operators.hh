@@ -10,37 +10,28 @@
 #define __LINALG_ARRAY_OPERATORS_HH__
 
 #include "array.hh"
+#include "expression.hh"
+#include <atomic>
 
 
 namespace Linalg {
 
 /**
- * Comparison of arrays.
+ * Element-wise comparison of arrays, the arrays are broadcast (see @c Array::broadcast).
  *
  * @ingroup operators
  */
 template <class T>
 Array<bool> operator== (const Array<T> &lhs, const Array<T> &rhs)
 {
-  // Check dims:
-  LINALG_SHAPE_ASSERT(lhs.ndim() == rhs.ndim());
-
-  // Check shape:
-  for (size_t i=0; i<lhs.ndim(); i++) {
-    LINALG_SHAPE_ASSERT(lhs.shape(i) == rhs.shape(i));
-  }
-
-  // Allocate result array:
-  Array<bool> res(lhs.shape());
+  // Allocate result array of the broadcast shape:
+  Array<bool> res(__broadcast_shape(lhs.shape(), rhs.shape()));
+  Shape lhs_strides = __broadcast_strides(lhs.shape(), lhs.strides(), res.shape());
+  Shape rhs_strides = __broadcast_strides(rhs.shape(), rhs.strides(), res.shape());
 
   // perform operation, element-wise:
-  ArrayConstIterator<T> lhs_iter = lhs.const_begin();
-  ArrayConstIterator<T> rhs_iter = rhs.const_begin();
-  Array<bool>::iterator res_iter = res.begin();
-
-  for (; lhs_iter != lhs.const_end(); lhs_iter++, rhs_iter++, res_iter++) {
-    *res_iter = (*lhs_iter == *rhs_iter);
-  }
+  __transform(res.shape(), res.ptr(), res.strides(), lhs.ptr(), lhs_strides,
+              rhs.ptr(), rhs_strides, [](const T &a, const T &b) { return a == b; });
 
   return res;
 }
@@ -51,13 +42,20 @@ Array<bool> operator== (const Array<T> &lhs, const Array<T> &rhs)
  */
 inline bool any(const Array<bool> &array)
 {
-  Array<bool>::const_iterator iter = array.const_begin();
-  for (; iter != array.const_end(); iter++) {
-    if (*iter)
-      return true;
-  }
-
-  return false;
+  std::atomic<bool> found(false);
+  StridedLoop<1> loop(array.shape(), &array.strides());
+  const bool *ptr = array.ptr();
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    if (found.load(std::memory_order_relaxed)) { return; }
+    const bool *p = ptr + offsets[0];
+    size_t inc = loop.innerStride(0);
+    for (size_t i=0; i<n; i++, p+=inc) {
+      if (*p) { found.store(true, std::memory_order_relaxed); return; }
+    }
+  });
+
+  return found.load();
 }
 
 
@@ -66,71 +64,37 @@ inline bool any(const Array<bool> &array)
  */
 inline bool all(const Array<bool> &array)
 {
-  Array<bool>::const_iterator iter = array.const_begin();
-  for (; iter != array.const_end(); iter++) {
-    if (! *iter)
-      return false;
-  }
-
-  return true;
-}
-
-
-/**
- * General implementation of array sum.
- *
- * @ingroup operators
- */
-template <class Scalar>
-inline Array<Scalar> operator+ (const Array<Scalar> &lhs, const Array<Scalar> &rhs)
-{
-  // Check dims:
-  LINALG_SHAPE_ASSERT(lhs.ndims() == rhs.ndims());
-
-  // Check shape:
-  for (size_t i=0; i<lhs.ndims(); i++) {
-    LINALG_SHAPE_ASSERT(lhs.dim(i) == rhs.dim(i));
-  }
-
-  // Allocate result array:
-  Array<Scalar> res(lhs.shape());
-
-  // perform operation, element-wise:
-  ArrayConstIterator<Scalar> lhs_iter = lhs.const_begin();
-  ArrayConstIterator<Scalar> rhs_iter = rhs.const_begin();
-  ArrayIterator<Scalar> res_iter = res.begin();
-
-  for (;! lhs_iter.atEnd(); lhs_iter++, rhs_iter++, res_iter++) {
-    *res_iter = *lhs_iter + *rhs_iter;
-  }
-
-  return res;
+  std::atomic<bool> failed(false);
+  StridedLoop<1> loop(array.shape(), &array.strides());
+  const bool *ptr = array.ptr();
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    if (failed.load(std::memory_order_relaxed)) { return; }
+    const bool *p = ptr + offsets[0];
+    size_t inc = loop.innerStride(0);
+    for (size_t i=0; i<n; i++, p+=inc) {
+      if (! *p) { failed.store(true, std::memory_order_relaxed); return; }
+    }
+  });
+
+  return ! failed.load();
 }
 
 
 /**
- * General implementation of array inplace-sum.
+ * General implementation of array inplace-sum, @c rhs is broadcast to the shape of @c lhs.
  *
  * @ingroup operators
  */
 template <class T>
 inline Array<T> &operator+= (Array<T> &lhs, const Array<T> &rhs)
 {
-  // Check dims:
-  LINALG_SHAPE_ASSERT(lhs.ndims() == rhs.ndims());
-
-  // Check shape:
-  for (size_t i=0; i<lhs.ndims(); i++) {
-    LINALG_SHAPE_ASSERT(lhs.dim(i) == rhs.dim(i));
-  }
+  // Broadcast rhs to the shape of lhs:
+  Shape rhs_strides = __broadcast_strides(rhs.shape(), rhs.strides(), lhs.shape());
 
   // perform operation, element-wise:
-  ArrayIterator<T> lhs_iter = lhs.begin();
-  ArrayConstIterator<T> rhs_iter = rhs.const_begin();
-
-  for (;! lhs_iter.atEnd(); lhs_iter++, rhs_iter++) {
-    *lhs_iter += *rhs_iter;
-  }
+  __transform(lhs.shape(), lhs.ptr(), lhs.strides(), lhs.ptr(), lhs.strides(),
+              rhs.ptr(), rhs_strides, [](const T &a, const T &b) { return a + b; });
 
   return lhs;
 }
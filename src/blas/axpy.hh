@@ -1,8 +1,9 @@
 #ifndef __LINALG_BLAS_AXPY_HH__
 #define __LINALG_BLAS_AXPY_HH__
 
-#include <vector.hh>
-#include <simd.hh>
+#include "view.hh"
+#include "simd.hh"
+#include "../utils.hh"
 
 
 namespace Linalg {
@@ -10,21 +11,22 @@ namespace Blas {
 
 
 /**
- * SIMD implementation of @c Linalg::Blas::axpy for dense vectors.
+ * SIMD implementation of @c Linalg::Blas::axpy for dense vectors, where @c XVec and @c YVec
+ * specify the (aligned or unaligned) SIMD vector unions used to access the elements of @c x
+ * and @c y. The remainder is processed by a scalar epilogue.
  *
  * @ingroup blas_internal
  */
-template <class Scalar>
-inline void __axpy_dense(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y)
+template <class Scalar, class XVec, class YVec>
+inline void __axpy_dense_simd(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y)
 throw ()
 {
-  typename SIMDTraits<Scalar>::uvector alpha_vec;
-  const typename SIMDTraits<Scalar>::uvector *x_ptr = (const typename SIMDTraits<Scalar>::uvector *)x;
-  typename SIMDTraits<Scalar>::uvector *y_ptr = (typename SIMDTraits<Scalar>::uvector *)y;
+  YVec alpha_vec;
+  const XVec *x_ptr = (const XVec *)x;
+  YVec *y_ptr = (YVec *)y;
 
-  size_t N_elm = SIMDTraits<Scalar>::num_elements;
+  size_t N_elm = sizeof(YVec)/sizeof(Scalar);
   size_t N_steps = N/N_elm;
-  size_t N_rem   = N%N_elm;
 
   // Initialize alpha_vector
   for (size_t i=0; i<N_elm; i++)
@@ -34,9 +36,206 @@ throw ()
   for (size_t i=0; i<N_steps; i++, x_ptr++, y_ptr++)
     y_ptr->v += alpha_vec.v * x_ptr->v;
 
-  // Perform on remaining elements
-  for (size_t i=0; i<N_rem; i++)
-    y_ptr->d[i] += alpha*x_ptr->d[i];
+  // Epilogue, perform on remaining elements
+  for (size_t i=N_steps*N_elm; i<N; i++)
+    y[i] += alpha*x[i];
+}
+
+
+/**
+ * SIMD implementation of @c Linalg::Blas::axpy for dense vectors using SIMD vectors of
+ * @c Bytes bytes. A scalar prologue processes the leading elements up to the alignment
+ * boundary of @c y, such that the main loop uses aligned loads and stores for @c y (and
+ * aligned loads for @c x, if it is aligned then too).
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline void __axpy_dense_isa(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y)
+{
+  typedef typename SIMDTraits<Scalar, Bytes>::auvector avec;
+  typedef typename SIMDTraits<Scalar, Bytes>::uvector uvec;
+
+  // Prologue:
+  size_t P = __simd_peel<Scalar, Bytes>(y, N);
+  for (size_t i=0; i<P; i++)
+    y[i] += alpha*x[i];
+  x += P; y += P; N -= P;
+
+  if (! __is_simd_aligned<Scalar, Bytes>(y)) {
+    __axpy_dense_simd<Scalar, uvec, uvec>(alpha, N, x, y);
+  } else if (__is_simd_aligned<Scalar, Bytes>(x)) {
+    __axpy_dense_simd<Scalar, avec, avec>(alpha, N, x, y);
+  } else {
+    __axpy_dense_simd<Scalar, uvec, avec>(alpha, N, x, y);
+  }
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __axpy_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX2 void
+__axpy_dense_avx2(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y) {
+  __axpy_dense_isa<Scalar, 32>(alpha, N, x, y);
+}
+
+
+/**
+ * Instantiates @c __axpy_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX512 void
+__axpy_dense_avx512(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y) {
+  __axpy_dense_isa<Scalar, 64>(alpha, N, x, y);
+}
+#endif
+
+
+/**
+ * SIMD implementation of @c Linalg::Blas::axpy for dense vectors, of the instruction set
+ * selected by @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline void __axpy_dense(const Scalar &alpha, size_t N, const Scalar *x, Scalar *y)
+throw ()
+{
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: __axpy_dense_avx512(alpha, N, x, y); return;
+  case SIMD::AVX2: __axpy_dense_avx2(alpha, N, x, y); return;
+  default: break;
+  }
+#endif
+
+  __axpy_dense_isa<Scalar, 16>(alpha, N, x, y);
+}
+
+
+/**
+ * SIMD implementation of @c Linalg::Blas::axpy for dense complex vectors, where @c XVec and
+ * @c YVec specify the (aligned or unaligned) SIMD vector unions of the real type used to
+ * access the interleaved real and imaginary parts of @c x and @c y. The complex product is
+ * computed as \f$\alpha_r(x_r,x_i) + \alpha_i(-x_i,x_r)\f$, i.e. with one shuffle per
+ * vector.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, class XVec, class YVec>
+inline void
+__axpy_complex_dense_simd(const std::complex<Real> &alpha, size_t N,
+                          const std::complex<Real> *x, std::complex<Real> *y)
+{
+  YVec alpha_re, alpha_im;
+  const XVec *x_ptr = (const XVec *)x;
+  YVec *y_ptr = (YVec *)y;
+
+  size_t N_elm = sizeof(YVec)/sizeof(Real);
+  size_t N_steps = (2*N)/N_elm;
+
+  // Initialize alpha vectors, the imaginary part with alternating signs:
+  for (size_t i=0; i<N_elm; i+=2) {
+    alpha_re.d[i] = alpha_re.d[i+1] = alpha.real();
+    alpha_im.d[i] = -alpha.imag(); alpha_im.d[i+1] = alpha.imag();
+  }
+
+  // Perform on vectors:
+  for (size_t i=0; i<N_steps; i++, x_ptr++, y_ptr++)
+    y_ptr->v += alpha_re.v * x_ptr->v + alpha_im.v * __simd_swap_pairs(*x_ptr).v;
+
+  // Epilogue, perform on remaining elements
+  for (size_t i=N_steps*N_elm/2; i<N; i++)
+    y[i] += __prod_ab(alpha, x[i]);
+}
+
+
+/**
+ * SIMD implementation of @c Linalg::Blas::axpy for dense complex vectors using SIMD vectors of
+ * @c Bytes bytes. Like @c __axpy_dense_isa, a scalar prologue aligns @c y if possible.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, size_t Bytes>
+inline void
+__axpy_complex_dense_isa(const std::complex<Real> &alpha, size_t N,
+                         const std::complex<Real> *x, std::complex<Real> *y)
+{
+  typedef typename SIMDTraits<Real, Bytes>::auvector avec;
+  typedef typename SIMDTraits<Real, Bytes>::uvector uvec;
+
+  // Prologue:
+  size_t P = __simd_peel<std::complex<Real>, Bytes>(y, N);
+  for (size_t i=0; i<P; i++)
+    y[i] += __prod_ab(alpha, x[i]);
+  x += P; y += P; N -= P;
+
+  if (! __is_simd_aligned<std::complex<Real>, Bytes>(y)) {
+    __axpy_complex_dense_simd<Real, uvec, uvec>(alpha, N, x, y);
+  } else if (__is_simd_aligned<std::complex<Real>, Bytes>(x)) {
+    __axpy_complex_dense_simd<Real, avec, avec>(alpha, N, x, y);
+  } else {
+    __axpy_complex_dense_simd<Real, uvec, avec>(alpha, N, x, y);
+  }
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __axpy_complex_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX2 void
+__axpy_complex_dense_avx2(const std::complex<Real> &alpha, size_t N,
+                          const std::complex<Real> *x, std::complex<Real> *y) {
+  __axpy_complex_dense_isa<Real, 32>(alpha, N, x, y);
+}
+
+
+/**
+ * Instantiates @c __axpy_complex_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX512 void
+__axpy_complex_dense_avx512(const std::complex<Real> &alpha, size_t N,
+                            const std::complex<Real> *x, std::complex<Real> *y) {
+  __axpy_complex_dense_isa<Real, 64>(alpha, N, x, y);
+}
+#endif
+
+
+/**
+ * SIMD implementation of @c Linalg::Blas::axpy for dense complex vectors, of the instruction
+ * set selected by @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+inline void
+__axpy_dense(const std::complex<Real> &alpha, size_t N, const std::complex<Real> *x,
+             std::complex<Real> *y)
+throw ()
+{
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: __axpy_complex_dense_avx512(alpha, N, x, y); return;
+  case SIMD::AVX2: __axpy_complex_dense_avx2(alpha, N, x, y); return;
+  default: break;
+  }
+#endif
+
+  __axpy_complex_dense_isa<Real, 16>(alpha, N, x, y);
 }
 
 
@@ -67,16 +266,16 @@ __axpy_incremental(const Scalar &alpha, size_t N, const Scalar *x, size_t x_inc,
  * @ingroup blas_internal
  */
 template<class Scalar>
-inline void __axpy(const Scalar &alpha, const Vector<Scalar> &x, Vector<Scalar> &y)
+inline void __axpy(const Scalar &alpha, const VectorView<Scalar> &x, const VectorView<Scalar> &y)
 throw ()
 {
-  if (0.0 == alpha)
+  if (Scalar(0) == alpha)
     return;
 
-  if ( (1 == x.strides()[0]) && (1 == y.strides()[0]))
+  if ( (1 == x.stride()) && (1 == y.stride()))
     __axpy_dense(alpha, x.dim(), x.ptr(), y.ptr());
   else
-    __axpy_incremental(alpha, x.dim(), x.ptr(), x.strides()[0], y.ptr(), y.strides()[0]);
+    __axpy_incremental(alpha, x.dim(), x.ptr(), x.stride(), y.ptr(), y.stride());
 }
 
 
@@ -89,7 +288,7 @@ throw ()
  * @ingroup blas1
  */
 template<class Scalar>
-inline void axpy(const Scalar &alpha, const Vector<Scalar> &x, Vector<Scalar> &y)
+inline void axpy(const Scalar &alpha, const VectorView<Scalar> &x, const VectorView<Scalar> &y)
 throw (ShapeError)
 {
   LINALG_SHAPE_ASSERT(x.dim() == y.dim());
@@ -98,6 +297,19 @@ throw (ShapeError)
 }
 
 
+/**
+ * Computes \f$y' = \alpha x + y\f$, see above.
+ *
+ * @ingroup blas1
+ */
+template<class Scalar>
+inline void axpy(const Scalar &alpha, const Vector<Scalar> &x, Vector<Scalar> &y)
+throw (ShapeError)
+{
+  axpy(alpha, __readonly_view(x), VectorView<Scalar>(y));
+}
+
+
 }
 }
 #endif // __LINALG_BLAS_AXPY_HH__
@@ -10,55 +10,340 @@
 #define __LINALG_BLAS_DOT_HH__
 
 #include "blas/utils.hh"
-#include "vector.hh"
+#include "view.hh"
 #include "simd.hh"
+#include "../utils.hh"
 
 
 namespace Linalg {
 namespace Blas {
 
 
+/**
+ * Implements the inner product of two dense vectors using SIMD instructions, where @c XVec and
+ * @c YVec specify the (aligned or unaligned) SIMD vector unions used to access the elements of
+ * @c x and @c y. The last @c N modulo the vector length elements are processed by a scalar
+ * epilogue, hence no element past the end is accessed.
+ *
+ * The products are accumulated into eight independent vectors, such that consecutive
+ * multiply-adds do not wait for the result of the previous one (eight covers the latency of a
+ * fused multiply-add times the number of FMA units of current x86 cores). Hence the throughput
+ * is limited by the loads, not by the latency of the multiply-add.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, class XVec, class YVec>
+Scalar __dot_dense_simd(size_t N, const Scalar *x, const Scalar *y)
+{
+  XVec acc[8];
+  const XVec *x_ptr = (const XVec *)x;
+  const YVec *y_ptr = (const YVec *)y;
+
+  // get n-blocks of all accumulators and single vectors
+  size_t N_elm   = sizeof(XVec)/sizeof(Scalar);
+  size_t N_block = N/(8*N_elm);
+  size_t N_step  = N/N_elm - N_block*8;
+
+  // Initialize accumulators:
+  for (size_t k=0; k<8; k++) {
+    for (size_t i=0; i<N_elm; i++) { acc[k].d[i] = Scalar(0); }
+  }
+
+  // Work on blocks of SIMD vectors, one per accumulator:
+  for (size_t i=0; i<N_block; i++, x_ptr+=8, y_ptr+=8) {
+    acc[0].v += x_ptr[0].v * y_ptr[0].v; acc[1].v += x_ptr[1].v * y_ptr[1].v;
+    acc[2].v += x_ptr[2].v * y_ptr[2].v; acc[3].v += x_ptr[3].v * y_ptr[3].v;
+    acc[4].v += x_ptr[4].v * y_ptr[4].v; acc[5].v += x_ptr[5].v * y_ptr[5].v;
+    acc[6].v += x_ptr[6].v * y_ptr[6].v; acc[7].v += x_ptr[7].v * y_ptr[7].v;
+  }
+
+  // Work on remaining SIMD vectors
+  for (size_t i=0; i<N_step; i++, x_ptr++, y_ptr++) {
+    acc[0].v += x_ptr->v * y_ptr->v;
+  }
+
+  // Compute sum, combine accumulators pairwise:
+  acc[0].v += acc[4].v; acc[1].v += acc[5].v; acc[2].v += acc[6].v; acc[3].v += acc[7].v;
+  acc[0].v += acc[2].v; acc[1].v += acc[3].v; acc[0].v += acc[1].v;
+  Scalar res = acc[0].d[0];
+  for (size_t i=1; i<N_elm; i++) {
+    res += acc[0].d[i];
+  }
+
+  // Epilogue, handle last elements:
+  for (size_t i=(N/N_elm)*N_elm; i<N; i++) {
+    res += x[i] * y[i];
+  }
+
+  return res;
+}
+
+
+/**
+ * Calculates the inner product of two dense vectors using SIMD vectors of @c Bytes bytes. A
+ * scalar prologue processes the leading elements up to the alignment boundary of @c x, such
+ * that the main loop uses aligned loads for @c x (and for @c y, if it is aligned then too).
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline Scalar __dot_dense_isa(size_t N, const Scalar *x, const Scalar *y)
+{
+  typedef typename SIMDTraits<Scalar, Bytes>::auvector avec;
+  typedef typename SIMDTraits<Scalar, Bytes>::uvector uvec;
+
+  // Prologue:
+  size_t P = __simd_peel<Scalar, Bytes>(x, N);
+  Scalar res = Scalar(0);
+  for (size_t i=0; i<P; i++) {
+    res += x[i] * y[i];
+  }
+  x += P; y += P; N -= P;
+
+  if (! __is_simd_aligned<Scalar, Bytes>(x)) {
+    return res + __dot_dense_simd<Scalar, uvec, uvec>(N, x, y);
+  }
+  if (__is_simd_aligned<Scalar, Bytes>(y)) {
+    return res + __dot_dense_simd<Scalar, avec, avec>(N, x, y);
+  }
+  return res + __dot_dense_simd<Scalar, avec, uvec>(N, x, y);
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __dot_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX2 Scalar __dot_dense_avx2(size_t N, const Scalar *x, const Scalar *y) {
+  return __dot_dense_isa<Scalar, 32>(N, x, y);
+}
+
+
+/**
+ * Instantiates @c __dot_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX512 Scalar __dot_dense_avx512(size_t N, const Scalar *x, const Scalar *y) {
+  return __dot_dense_isa<Scalar, 64>(N, x, y);
+}
+#endif
+
+
 /**
  * Specialized, internal function to calculate the inner product of two dense vectors in an
- * efficient way using SIMD instructions.
+ * efficient way using SIMD instructions, of the instruction set selected by @c SIMD::level().
  *
  * @note This function does no dimension checks on x and y.
  *
  * @ingroup blas_internal
  */
 template <class Scalar>
-Scalar __dot_dense(size_t N, const Scalar *x, const Scalar *y)
+inline Scalar __dot_dense(size_t N, const Scalar *x, const Scalar *y)
 {
-  typename SIMDTraits<Scalar>::uvector res;
-  const typename SIMDTraits<Scalar>::uvector *x_ptr = (const typename SIMDTraits<Scalar>::uvector *)x;
-  const typename SIMDTraits<Scalar>::uvector *y_ptr = (const typename SIMDTraits<Scalar>::uvector *)y;
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: return __dot_dense_avx512(N, x, y);
+  case SIMD::AVX2: return __dot_dense_avx2(N, x, y);
+  default: break;
+  }
+#endif
+
+  return __dot_dense_isa<Scalar, 16>(N, x, y);
+}
 
-  // get n-blocks, and remainder
-  size_t N_elm  = SIMDTraits<Scalar>::num_elements;
-  size_t N_step = N/N_elm;
-  size_t N_rem  = N%N_elm;
 
-  // Initialize result vector:
-  for (size_t i=0; i<N_elm; i++) {
-    res.d[i] = Scalar(0);
+/**
+ * Implements the inner product of two dense complex vectors using SIMD instructions, where
+ * @c XVec and @c YVec specify the (aligned or unaligned) SIMD vector unions of the real type
+ * used to access the interleaved real and imaginary parts of @c x and @c y. If @c conj is true,
+ * @c x is conjugated.
+ *
+ * With the products of the vectors \f$(x_r,x_i)(y_r,y_i)\f$ and \f$(x_r,x_i)(y_i,y_r)\f$
+ * (i.e. with swapped pairs of @c y), accumulated into four independent vectors each, the real
+ * part is the sum of the even minus the odd elements of the first (plus if conjugated) and the
+ * imaginary part is the sum of the even plus the odd elements of the second (minus if
+ * conjugated). Hence, the main loop needs only one shuffle per vector.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, class XVec, class YVec>
+std::complex<Real>
+__dot_complex_dense_simd(size_t N, const std::complex<Real> *x, const std::complex<Real> *y,
+                         bool conj)
+{
+  XVec acc[8];
+  const XVec *x_ptr = (const XVec *)x;
+  const YVec *y_ptr = (const YVec *)y;
+
+  // get n-blocks of the accumulators and single vectors (of real elements)
+  size_t N_elm   = sizeof(XVec)/sizeof(Real);
+  size_t N_block = (2*N)/(4*N_elm);
+  size_t N_step  = (2*N)/N_elm - N_block*4;
+
+  // Initialize accumulators:
+  for (size_t k=0; k<8; k++) {
+    for (size_t i=0; i<N_elm; i++) { acc[k].d[i] = Real(0); }
   }
 
-  // Work on SIMD vectors
+  // Work on blocks of SIMD vectors, acc[0-3] hold the direct, acc[4-7] the swapped products:
+  for (size_t i=0; i<N_block; i++, x_ptr+=4, y_ptr+=4) {
+    acc[0].v += x_ptr[0].v * y_ptr[0].v; acc[4].v += x_ptr[0].v * __simd_swap_pairs(y_ptr[0]).v;
+    acc[1].v += x_ptr[1].v * y_ptr[1].v; acc[5].v += x_ptr[1].v * __simd_swap_pairs(y_ptr[1]).v;
+    acc[2].v += x_ptr[2].v * y_ptr[2].v; acc[6].v += x_ptr[2].v * __simd_swap_pairs(y_ptr[2]).v;
+    acc[3].v += x_ptr[3].v * y_ptr[3].v; acc[7].v += x_ptr[3].v * __simd_swap_pairs(y_ptr[3]).v;
+  }
+
+  // Work on remaining SIMD vectors
   for (size_t i=0; i<N_step; i++, x_ptr++, y_ptr++) {
-    res.v += x_ptr->v * y_ptr->v;
+    acc[0].v += x_ptr->v * y_ptr->v; acc[4].v += x_ptr->v * __simd_swap_pairs(*y_ptr).v;
   }
 
-  // Handle last elements...
-  for (size_t i=0; i<N_rem; i++) {
-    res.d[i] += x_ptr->d[i] * y_ptr->d[i];
+  // Compute sums, combine accumulators pairwise:
+  acc[0].v += acc[1].v; acc[2].v += acc[3].v; acc[0].v += acc[2].v;
+  acc[4].v += acc[5].v; acc[6].v += acc[7].v; acc[4].v += acc[6].v;
+  Real re_even = 0, re_odd = 0, im_even = 0, im_odd = 0;
+  for (size_t i=0; i<N_elm; i+=2) {
+    re_even += acc[0].d[i]; re_odd += acc[0].d[i+1];
+    im_even += acc[4].d[i]; im_odd += acc[4].d[i+1];
   }
+  std::complex<Real> res = conj ? std::complex<Real>(re_even + re_odd, im_even - im_odd)
+                                : std::complex<Real>(re_even - re_odd, im_even + im_odd);
 
-  // Compute sum:
-  for (size_t i=1; i<N_elm; i++) {
-    res.d[0] += res.d[i];
+  // Epilogue, handle last elements:
+  for (size_t i=((2*N)/N_elm)*N_elm/2; i<N; i++) {
+    res += conj ? __prod_abcc(y[i], x[i]) : __prod_ab(x[i], y[i]);
+  }
+
+  return res;
+}
+
+
+/**
+ * Calculates the (conjugated if @c conj is true) inner product of two dense complex vectors
+ * using SIMD vectors of @c Bytes bytes. Like @c __dot_dense_isa, a scalar prologue aligns
+ * @c x if possible.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, size_t Bytes>
+inline std::complex<Real>
+__dot_complex_dense_isa(size_t N, const std::complex<Real> *x, const std::complex<Real> *y,
+                        bool conj)
+{
+  typedef typename SIMDTraits<Real, Bytes>::auvector avec;
+  typedef typename SIMDTraits<Real, Bytes>::uvector uvec;
+
+  // Prologue:
+  size_t P = __simd_peel<std::complex<Real>, Bytes>(x, N);
+  std::complex<Real> res = Real(0);
+  for (size_t i=0; i<P; i++) {
+    res += conj ? __prod_abcc(y[i], x[i]) : __prod_ab(x[i], y[i]);
+  }
+  x += P; y += P; N -= P;
+
+  if (! __is_simd_aligned<std::complex<Real>, Bytes>(x)) {
+    return res + __dot_complex_dense_simd<Real, uvec, uvec>(N, x, y, conj);
+  }
+  if (__is_simd_aligned<std::complex<Real>, Bytes>(y)) {
+    return res + __dot_complex_dense_simd<Real, avec, avec>(N, x, y, conj);
+  }
+  return res + __dot_complex_dense_simd<Real, avec, uvec>(N, x, y, conj);
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __dot_complex_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX2 std::complex<Real>
+__dot_complex_dense_avx2(size_t N, const std::complex<Real> *x, const std::complex<Real> *y,
+                         bool conj) {
+  return __dot_complex_dense_isa<Real, 32>(N, x, y, conj);
+}
+
+
+/**
+ * Instantiates @c __dot_complex_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX512 std::complex<Real>
+__dot_complex_dense_avx512(size_t N, const std::complex<Real> *x, const std::complex<Real> *y,
+                           bool conj) {
+  return __dot_complex_dense_isa<Real, 64>(N, x, y, conj);
+}
+#endif
+
+
+/**
+ * Internal function to calculate the (conjugated if @c conj is true) inner product of two
+ * dense complex vectors using SIMD instructions, of the instruction set selected by
+ * @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+inline std::complex<Real>
+__dot_complex_dense(size_t N, const std::complex<Real> *x, const std::complex<Real> *y,
+                    bool conj)
+{
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: return __dot_complex_dense_avx512(N, x, y, conj);
+  case SIMD::AVX2: return __dot_complex_dense_avx2(N, x, y, conj);
+  default: break;
   }
+#endif
+
+  return __dot_complex_dense_isa<Real, 16>(N, x, y, conj);
+}
+
+
+/**
+ * Calculates the inner product \f$x^Ty\f$ of two dense complex vectors, see above.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+inline std::complex<Real>
+__dot_dense(size_t N, const std::complex<Real> *x, const std::complex<Real> *y)
+{
+  return __dot_complex_dense(N, x, y, false);
+}
+
+
+/**
+ * Calculates the conjugated inner product \f$x^Hy\f$ of two dense vectors, which is the
+ * inner product for real vectors.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline Scalar __dotc_dense(size_t N, const Scalar *x, const Scalar *y)
+{
+  return __dot_dense(N, x, y);
+}
+
 
-  return res.d[0];
+/**
+ * Calculates the conjugated inner product \f$x^Hy\f$ of two dense complex vectors.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+inline std::complex<Real>
+__dotc_dense(size_t N, const std::complex<Real> *x, const std::complex<Real> *y)
+{
+  return __dot_complex_dense(N, x, y, true);
 }
 
 
@@ -82,6 +367,26 @@ inline Scalar __dot_incremental(size_t N, const Scalar *x, size_t inc_x, const S
 }
 
 
+/**
+ * Internal used function, calculating the conjugated inner product as \f$x^Hy\f$.
+ *
+ * @note This function does no dimension check on x & y.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline Scalar __dotc_incremental(size_t N, const Scalar *x, size_t inc_x, const Scalar *y, size_t inc_y)
+{
+  Scalar r = Scalar(0);
+
+  for (size_t i=0; i<N; i++, x+=inc_x, y+=inc_y) {
+    r += __prod_abcc(*y, *x);
+  }
+
+  return r;
+}
+
+
 /**
  * Calculates the dot product of two vectors x and y.
  *
@@ -93,7 +398,7 @@ inline Scalar __dot_incremental(size_t N, const Scalar *x, size_t inc_x, const S
  * @ingroup blas1
  */
 template <class Scalar>
-inline Scalar dot(const Vector<Scalar> &x, const Vector<Scalar> &y)
+inline Scalar dot(const VectorView<Scalar> &x, const VectorView<Scalar> &y)
 {
   LINALG_SHAPE_ASSERT(x.dim() == y.dim());
 
@@ -103,7 +408,7 @@ inline Scalar dot(const Vector<Scalar> &x, const Vector<Scalar> &y)
 
   // If x and y are dense, use optimized methods:
   if ( (1 == incx) && (1 == incy) ) {
-    return __dot_dense<Scalar>(N, x.ptr(), y.ptr());
+    return __dot_dense(N, x.ptr(), y.ptr());
   }
 
   // otherwise use incremental operation
@@ -111,6 +416,55 @@ inline Scalar dot(const Vector<Scalar> &x, const Vector<Scalar> &y)
 }
 
 
+/**
+ * Calculates the dot product of two vectors x and y, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline Scalar dot(const Vector<Scalar> &x, const Vector<Scalar> &y)
+{
+  return dot(__readonly_view(x), __readonly_view(y));
+}
+
+
+
+/**
+ * Calculates the conjugated dot product of two vectors x and y, i.e. the dot product for real
+ * vectors.
+ *
+ * \f[dotc(x,y) = x^H\cdot y\f]
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline Scalar dotc(const VectorView<Scalar> &x, const VectorView<Scalar> &y)
+{
+  LINALG_SHAPE_ASSERT(x.dim() == y.dim());
+
+  int N    = BLAS_DIMENSION(x);
+  int incx = BLAS_INCREMENT(x);
+  int incy = BLAS_INCREMENT(y);
+
+  if ( (1 == incx) && (1 == incy) ) {
+    return __dotc_dense(N, x.ptr(), y.ptr());
+  }
+
+  return __dotc_incremental<Scalar>(N, x.ptr(), incx, y.ptr(), incy);
+}
+
+
+/**
+ * Calculates the conjugated dot product of two vectors x and y, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline Scalar dotc(const Vector<Scalar> &x, const Vector<Scalar> &y)
+{
+  return dotc(__readonly_view(x), __readonly_view(y));
+}
+
 }
 }
 
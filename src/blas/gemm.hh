@@ -11,7 +11,7 @@
 
 
 #include "blas/utils.hh"
-#include "matrix.hh"
+#include "view.hh"
 
 
 extern "C" {
@@ -36,8 +36,8 @@ namespace Blas {
  *
  * @ingroup blas3
  */
-inline void gemm(double alpha, const Matrix<double> &A, const Matrix<double> &B,
-          double beta, Matrix<double> &C)
+inline void gemm(double alpha, const MatrixView<double> &A, const MatrixView<double> &B,
+          double beta, const MatrixView<double> &C)
 {
   // Check matrix shape:
   LINALG_SHAPE_ASSERT(A.cols() == B.rows());
@@ -46,9 +46,9 @@ inline void gemm(double alpha, const Matrix<double> &A, const Matrix<double> &B,
 
   // Get matrices in column-major from:
   char transa='N', transb='N', transc = 'N';
-  Matrix<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, transa);
-  Matrix<double> Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
-  Matrix<double> Ccol = C; BLAS_ENSURE_COLUMN_MAJOR(Ccol, transc);
+  MatrixView<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, transa);
+  MatrixView<double> Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
+  MatrixView<double> Ccol = C; BLAS_ENSURE_COLUMN_MAJOR(Ccol, transc);
 
   if ('T' == transc) {
     std::swap(Acol, Bcol);
@@ -18,7 +18,7 @@ extern void dgemv_(const char *trans, const int *m, const int *n,
 
 
 #include "blas/utils.hh"
-#include "matrix.hh"
+#include "view.hh"
 
 
 namespace Linalg {
@@ -33,12 +33,12 @@ namespace Blas {
  *
  * @ingroup blas2
  */
-inline void gemv(const double alpha, const Matrix<double> &A, const Vector<double> &x,
-          const double beta, Vector<double> &y)
+inline void gemv(const double alpha, const MatrixView<double> &A, const VectorView<double> &x,
+          const double beta, const VectorView<double> &y)
 {
   // Get matrix in column order (Fortran)
   char trans = 'N';
-  Matrix<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, trans);
+  MatrixView<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, trans);
 
   LINALG_SHAPE_ASSERT(A.cols() == x.dim());
   LINALG_SHAPE_ASSERT(A.rows() == y.dim());
@@ -11,9 +11,11 @@
 
 
 #include "blas/utils.hh"
-#include "vector.hh"
+#include "view.hh"
 #include "simd.hh"
 #include <cmath>
+#include <limits>
+#include <complex>
 
 
 namespace Linalg {
@@ -21,40 +23,122 @@ namespace Blas {
 
 
 /**
- * Internal function to perform @c nrm2sq using SIMD instructions.
+ * Implements @c nrm2sq using SIMD instructions, where @c VecType specifies the (aligned or
+ * unaligned) SIMD vector union used to access the elements. Like @c __dot_dense_simd, the
+ * squares are accumulated into eight independent vectors and the remainder is processed by a
+ * scalar epilogue.
  *
  * @ingroup blas_internal
  */
-template <class Scalar>
-inline Scalar __nrm2sq_dense(size_t N, const Scalar *x) {
-  typename SIMDTraits<Scalar>::uvector res;
-  const typename SIMDTraits<Scalar>::uvector *x_ptr = (const typename SIMDTraits<Scalar>::uvector *)x;
+template <class Scalar, class VecType>
+inline Scalar __nrm2sq_dense_simd(size_t N, const Scalar *x) {
+  VecType acc[8];
+  const VecType *x_ptr = (const VecType *)x;
 
-  size_t N_elm  = SIMDTraits<Scalar>::num_elements;
-  size_t N_step = N/N_elm;
-  size_t N_rem  = N%N_elm;
+  size_t N_elm   = sizeof(VecType)/sizeof(Scalar);
+  size_t N_block = N/(8*N_elm);
+  size_t N_step  = N/N_elm - N_block*8;
 
-  // Initialize result vector:
-  for (size_t i=0; i<N_elm; i++) {
-    res.d[i] = Scalar(0);
+  // Initialize accumulators:
+  for (size_t k=0; k<8; k++) {
+    for (size_t i=0; i<N_elm; i++) { acc[k].d[i] = Scalar(0); }
   }
 
-  // Perform operations on vectors:
-  for(size_t i=0; i<N_step; i++, x_ptr++) {
-    res.v += x_ptr->v * x_ptr->v;
+  // Perform operations on blocks of vectors, one per accumulator:
+  for (size_t i=0; i<N_block; i++, x_ptr+=8) {
+    acc[0].v += x_ptr[0].v * x_ptr[0].v; acc[1].v += x_ptr[1].v * x_ptr[1].v;
+    acc[2].v += x_ptr[2].v * x_ptr[2].v; acc[3].v += x_ptr[3].v * x_ptr[3].v;
+    acc[4].v += x_ptr[4].v * x_ptr[4].v; acc[5].v += x_ptr[5].v * x_ptr[5].v;
+    acc[6].v += x_ptr[6].v * x_ptr[6].v; acc[7].v += x_ptr[7].v * x_ptr[7].v;
   }
 
-  // Handle remaining elements:
-  for (size_t i=0; i<N_rem; i++) {
-    res.d[i] += x_ptr->d[i] * x_ptr->d[i];
+  // Perform operations on remaining vectors:
+  for(size_t i=0; i<N_step; i++, x_ptr++) {
+    acc[0].v += x_ptr->v * x_ptr->v;
   }
 
-  // calc result
+  // calc result, combine accumulators pairwise:
+  acc[0].v += acc[4].v; acc[1].v += acc[5].v; acc[2].v += acc[6].v; acc[3].v += acc[7].v;
+  acc[0].v += acc[2].v; acc[1].v += acc[3].v; acc[0].v += acc[1].v;
+  Scalar res = acc[0].d[0];
   for (size_t i=1; i<N_elm; i++) {
-    res.d[0] += res.d[i];
+    res += acc[0].d[i];
+  }
+
+  // Epilogue, handle remaining elements:
+  for (size_t i=(N/N_elm)*N_elm; i<N; i++) {
+    res += x[i] * x[i];
+  }
+
+  return res;
+}
+
+
+/**
+ * Performs @c nrm2sq using SIMD vectors of @c Bytes bytes. A scalar prologue processes the
+ * leading elements up to the alignment boundary, such that the main loop uses aligned loads.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline Scalar __nrm2sq_dense_isa(size_t N, const Scalar *x)
+{
+  // Prologue:
+  size_t P = __simd_peel<Scalar, Bytes>(x, N);
+  Scalar res = Scalar(0);
+  for (size_t i=0; i<P; i++) {
+    res += x[i] * x[i];
   }
+  x += P; N -= P;
+
+  if (__is_simd_aligned<Scalar, Bytes>(x)) {
+    return res + __nrm2sq_dense_simd<Scalar, typename SIMDTraits<Scalar, Bytes>::auvector>(N, x);
+  }
+  return res + __nrm2sq_dense_simd<Scalar, typename SIMDTraits<Scalar, Bytes>::uvector>(N, x);
+}
 
-  return res.d[0];
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __nrm2sq_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX2 Scalar __nrm2sq_dense_avx2(size_t N, const Scalar *x) {
+  return __nrm2sq_dense_isa<Scalar, 32>(N, x);
+}
+
+
+/**
+ * Instantiates @c __nrm2sq_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX512 Scalar __nrm2sq_dense_avx512(size_t N, const Scalar *x) {
+  return __nrm2sq_dense_isa<Scalar, 64>(N, x);
+}
+#endif
+
+
+/**
+ * Internal function to perform @c nrm2sq using SIMD instructions, of the instruction set
+ * selected by @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline Scalar __nrm2sq_dense(size_t N, const Scalar *x) {
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: return __nrm2sq_dense_avx512(N, x);
+  case SIMD::AVX2: return __nrm2sq_dense_avx2(N, x);
+  default: break;
+  }
+#endif
+
+  return __nrm2sq_dense_isa<Scalar, 16>(N, x);
 }
 
 
@@ -84,7 +168,7 @@ inline Scalar __nrm2sq_incremental(size_t N, const Scalar *x, size_t incx) {
  * @ingroup blas1
  */
 template <class Scalar>
-inline Scalar nrm2sq(const Vector<Scalar> &x)
+inline Scalar nrm2sq(const VectorView<Scalar> &x)
 {
   int N   = BLAS_DIMENSION(x);
   int INC = BLAS_INCREMENT(x);
@@ -97,25 +181,273 @@ inline Scalar nrm2sq(const Vector<Scalar> &x)
 }
 
 
+/**
+ * Calculates squared 2-norm of a vector, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline Scalar nrm2sq(const Vector<Scalar> &x)
+{
+  return nrm2sq(__readonly_view(x));
+}
+
+
+/**
+ * Calculates squared 2-norm of a complex vector, i.e. the sum of the squares of the real and
+ * imaginary parts, using the real kernels on the interleaved parts.
+ *
+ * @ingroup blas1
+ */
+template <class Real>
+inline Real nrm2sq(const VectorView< std::complex<Real> > &x)
+{
+  int N   = BLAS_DIMENSION(x);
+  int INC = BLAS_INCREMENT(x);
+  const Real *parts = (const Real *)x.ptr();
+
+  if (1 == INC) {
+    return __nrm2sq_dense(2*N, parts);
+  }
+
+  return __nrm2sq_incremental(N, parts, 2*INC) + __nrm2sq_incremental(N, parts+1, 2*INC);
+}
+
+
+/**
+ * Calculates squared 2-norm of a complex vector, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Real>
+inline Real nrm2sq(const Vector< std::complex<Real> > &x)
+{
+  return nrm2sq(__readonly_view(x));
+}
+
+
+
+/**
+ * Internal function to compute the largest absolute value of a dense vector using SIMD vectors
+ * of @c Bytes bytes, the elements must not be NaN.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline Scalar __amax_dense(size_t N, const Scalar *x)
+{
+  const size_t N_elm = SIMDTraits<Scalar, Bytes>::num_elements;
+  const typename SIMDTraits<Scalar, Bytes>::uvector *x_ptr =
+      (const typename SIMDTraits<Scalar, Bytes>::uvector *)x;
+
+  typename SIMDTraits<Scalar, Bytes>::vector m0 = {}, m1 = m0, m2 = m0, m3 = m0, a0, a1, a2, a3;
+
+  // Four independent maxima of the absolute values:
+  size_t N_block = N/(4*N_elm);
+  for (size_t i=0; i<N_block; i++, x_ptr+=4) {
+    a0 = x_ptr[0].v; a1 = x_ptr[1].v; a2 = x_ptr[2].v; a3 = x_ptr[3].v;
+    a0 = (a0 < -a0) ? -a0 : a0; a1 = (a1 < -a1) ? -a1 : a1;
+    a2 = (a2 < -a2) ? -a2 : a2; a3 = (a3 < -a3) ? -a3 : a3;
+    m0 = (a0 > m0) ? a0 : m0; m1 = (a1 > m1) ? a1 : m1;
+    m2 = (a2 > m2) ? a2 : m2; m3 = (a3 > m3) ? a3 : m3;
+  }
+
+  m0 = (m1 > m0) ? m1 : m0; m2 = (m3 > m2) ? m3 : m2; m0 = (m2 > m0) ? m2 : m0;
+  Scalar res = Scalar(0);
+  for (size_t i=0; i<N_elm; i++) {
+    res = std::max(res, m0[i]);
+  }
+  for (size_t i=N_block*4*N_elm; i<N; i++) {
+    res = std::max(res, std::abs(x[i]));
+  }
+
+  return res;
+}
+
+
+/**
+ * Computes the 2-norm of a (dense or strided) vector without overflow or underflow of the
+ * squares, using SIMD vectors of @c Bytes bytes. The vector is processed in chunks (copied to a
+ * buffer on the stack if strided) that fit into the L1 cache: The largest absolute value of the
+ * chunk determines a power of two that scales the chunk (exactly) into [0,2) before its squares
+ * are summed by @c __nrm2sq_dense_isa. If a chunk needs a smaller scale than the previous ones,
+ * the sum is rescaled. Hence, the vector is read only once from memory. The elements must not
+ * be NaN.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline Scalar __nrm2_scaled_isa(size_t N, const Scalar *x, size_t incx)
+{
+  typedef typename SIMDTraits<Scalar, Bytes>::uvector UVecType;
+  const size_t N_elm = SIMDTraits<Scalar, Bytes>::num_elements;
+  const size_t B = 512;
+  typename SIMDTraits<Scalar, Bytes>::auvector buffer[B/N_elm];
+  Scalar *buf = buffer[0].d;
+
+  // The sum of the squares of the elements scaled by 2^e:
+  Scalar res = Scalar(0);
+  int e = 0;
+
+  for (size_t i0=0; i0<N; i0+=B) {
+    size_t n = std::min(B, N-i0);
+    const Scalar *chunk = x + i0*incx;
+    if (1 != incx) {
+      for (size_t i=0; i<n; i++) { buf[i] = chunk[i*incx]; }
+      chunk = buf;
+    }
+
+    Scalar amax = __amax_dense<Scalar, Bytes>(n, chunk);
+    if (Scalar(0) == amax) { continue; }
+    if (! std::isfinite(amax)) { return amax; }
+
+    // Exponent, such that amax*2^e is in [1,2) (or as close as possible if amax is subnormal):
+    int ce = std::min(-std::ilogb(amax), std::numeric_limits<Scalar>::max_exponent-1);
+    if ((Scalar(0) == res) || (ce < e)) {
+      res = std::ldexp(res, 2*(ce-e)); e = ce;
+    }
+
+    const Scalar scale = std::ldexp(Scalar(1), e);
+    const UVecType *c_ptr = (const UVecType *)chunk;
+    size_t N_vec = n/N_elm;
+    for (size_t i=0; i<N_vec; i++) {
+      buffer[i].v = scale * c_ptr[i].v;
+    }
+    for (size_t i=N_vec*N_elm; i<n; i++) {
+      buf[i] = scale*chunk[i];
+    }
+    res += __nrm2sq_dense_isa<Scalar, Bytes>(n, buf);
+  }
+
+  return std::ldexp(std::sqrt(res), -e);
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __nrm2_scaled_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX2 Scalar __nrm2_scaled_avx2(size_t N, const Scalar *x, size_t incx) {
+  return __nrm2_scaled_isa<Scalar, 32>(N, x, incx);
+}
+
+
+/**
+ * Instantiates @c __nrm2_scaled_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX512 Scalar __nrm2_scaled_avx512(size_t N, const Scalar *x, size_t incx) {
+  return __nrm2_scaled_isa<Scalar, 64>(N, x, incx);
+}
+#endif
+
+
+/**
+ * Internal function to compute the 2-norm without overflow or underflow using SIMD
+ * instructions, of the instruction set selected by @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline Scalar __nrm2_scaled(size_t N, const Scalar *x, size_t incx) {
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: return __nrm2_scaled_avx512(N, x, incx);
+  case SIMD::AVX2: return __nrm2_scaled_avx2(N, x, incx);
+  default: break;
+  }
+#endif
+
+  return __nrm2_scaled_isa<Scalar, 16>(N, x, incx);
+}
+
 
 /**
  * Calculates 2-norm of a vector.
  *
  * \f[nrm2(x) = \sqrt{dot(x,x)} \f]
  *
+ * The sum of squares is computed directly (a single pass with the SIMD kernel). Only if it
+ * overflowed or is too small to be accurate (below @c min/epsilon), the norm is recomputed by
+ * the scaled two-pass algorithm @c __nrm2_scaled. NaN elements give a NaN sum, which is
+ * returned as it is.
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline Scalar nrm2(const VectorView<Scalar> &x)
+{
+  int N   = BLAS_DIMENSION(x);
+  int INC = BLAS_INCREMENT(x);
+
+  Scalar res = (1 == INC) ? __nrm2sq_dense(N, x.ptr()) : __nrm2sq_incremental(N, x.ptr(), INC);
+  const Scalar tiny = std::numeric_limits<Scalar>::min()/std::numeric_limits<Scalar>::epsilon();
+  if (res != res) {
+    return res;
+  }
+  if (std::isfinite(res) && (res >= tiny)) {
+    return std::sqrt(res);
+  }
+
+  return __nrm2_scaled(N, x.ptr(), INC);
+}
+
+
+/**
+ * Calculates 2-norm of a vector, see above.
+ *
  * @ingroup blas1
  */
 template <class Scalar>
 inline Scalar nrm2(const Vector<Scalar> &x)
+{
+  return nrm2(__readonly_view(x));
+}
+
+
+/**
+ * Calculates 2-norm of a complex vector, using the real kernels on the interleaved real and
+ * imaginary parts (like @c nrm2 for real vectors, with a scaled fallback).
+ *
+ * @ingroup blas1
+ */
+template <class Real>
+inline Real nrm2(const VectorView< std::complex<Real> > &x)
 {
   int N   = BLAS_DIMENSION(x);
   int INC = BLAS_INCREMENT(x);
+  const Real *parts = (const Real *)x.ptr();
+
+  Real res = nrm2sq(x);
+  const Real tiny = std::numeric_limits<Real>::min()/std::numeric_limits<Real>::epsilon();
+  if (res != res) {
+    return res;
+  }
+  if (std::isfinite(res) && (res >= tiny)) {
+    return std::sqrt(res);
+  }
 
   if (1 == INC) {
-    return sqrt(__nrm2sq_dense(N, x.ptr()));
+    return __nrm2_scaled(2*N, parts, 1);
   }
+  return std::hypot(__nrm2_scaled(N, parts, 2*INC), __nrm2_scaled(N, parts+1, 2*INC));
+}
+
 
-  return sqrt(__nrm2sq_incremental(N, x.ptr(), INC));
+/**
+ * Calculates 2-norm of a complex vector, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Real>
+inline Real nrm2(const Vector< std::complex<Real> > &x)
+{
+  return nrm2(__readonly_view(x));
 }
 
 
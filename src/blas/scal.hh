@@ -9,9 +9,10 @@
 #ifndef __LINALG_BLAS_SCAL_HH__
 #define __LINALG_BLAS_SCAL_HH__
 
-#include "vector.hh"
+#include "view.hh"
 #include "utils.hh"
 #include "simd.hh"
+#include "../utils.hh"
 
 
 namespace Linalg {
@@ -19,19 +20,18 @@ namespace Blas {
 
 
 /**
- * Optimized internal function to scale a vector using SIMD instructions if the vector is dense
- * (increment 1).
+ * Implements the scaling of a dense vector using SIMD instructions, where @c VecType specifies
+ * the (aligned or unaligned) SIMD vector union used to access the elements.
  *
  * @ingroup blas_internal
  */
-template <class Scalar>
-inline void __scal_dense(size_t N, const Scalar &a, Scalar *x) {
-  typename SIMDTraits<Scalar>::uvector a_vec;
-  typename SIMDTraits<Scalar>::uvector *x_ptr = (typename SIMDTraits<Scalar>::uvector *)x;
+template <class Scalar, class VecType>
+inline void __scal_dense_simd(size_t N, const Scalar &a, Scalar *x) {
+  VecType a_vec;
+  VecType *x_ptr = (VecType *)x;
 
-  size_t N_elm  = SIMDTraits<Scalar>::num_elements;
+  size_t N_elm  = sizeof(VecType)/sizeof(Scalar);
   size_t N_step = N/N_elm;
-  size_t N_rem  = N%N_elm;
 
   // Initialize constant vector a_vec
   for (size_t i=0; i<N_elm; i++) {
@@ -43,10 +43,183 @@ inline void __scal_dense(size_t N, const Scalar &a, Scalar *x) {
     x_ptr->v *= a_vec.v;
   }
 
-  // Handle remaining elements:
-  for (size_t i=0; i<N_rem; i++) {
-    x_ptr->d[i] *= a;
+  // Epilogue, handle remaining elements:
+  for (size_t i=N_step*N_elm; i<N; i++) {
+    x[i] *= a;
+  }
+}
+
+
+/**
+ * Scales a dense vector using SIMD vectors of @c Bytes bytes. A scalar prologue processes the
+ * leading elements up to the alignment boundary, such that the main loop uses aligned loads
+ * and stores.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar, size_t Bytes>
+inline void __scal_dense_isa(size_t N, const Scalar &a, Scalar *x)
+{
+  // Prologue:
+  size_t P = __simd_peel<Scalar, Bytes>(x, N);
+  for (size_t i=0; i<P; i++) {
+    x[i] *= a;
+  }
+  x += P; N -= P;
+
+  if (__is_simd_aligned<Scalar, Bytes>(x)) {
+    __scal_dense_simd<Scalar, typename SIMDTraits<Scalar, Bytes>::auvector>(N, a, x);
+  } else {
+    __scal_dense_simd<Scalar, typename SIMDTraits<Scalar, Bytes>::uvector>(N, a, x);
+  }
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __scal_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX2 void __scal_dense_avx2(size_t N, const Scalar &a, Scalar *x) {
+  __scal_dense_isa<Scalar, 32>(N, a, x);
+}
+
+
+/**
+ * Instantiates @c __scal_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+LINALG_TARGET_AVX512 void __scal_dense_avx512(size_t N, const Scalar &a, Scalar *x) {
+  __scal_dense_isa<Scalar, 64>(N, a, x);
+}
+#endif
+
+
+/**
+ * Optimized internal function to scale a vector using SIMD instructions if the vector is dense
+ * (increment 1), of the instruction set selected by @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Scalar>
+inline void __scal_dense(size_t N, const Scalar &a, Scalar *x) {
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: __scal_dense_avx512(N, a, x); return;
+  case SIMD::AVX2: __scal_dense_avx2(N, a, x); return;
+  default: break;
+  }
+#endif
+
+  __scal_dense_isa<Scalar, 16>(N, a, x);
+}
+
+
+/**
+ * Implements the scaling of a dense complex vector using SIMD instructions, where @c VecType
+ * specifies the (aligned or unaligned) SIMD vector union of the real type used to access the
+ * interleaved real and imaginary parts. Like @c __axpy_complex_dense_simd, the product is
+ * computed as \f$a_r(x_r,x_i) + a_i(-x_i,x_r)\f$.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, class VecType>
+inline void __scal_complex_dense_simd(size_t N, const std::complex<Real> &a, std::complex<Real> *x) {
+  VecType a_re, a_im;
+  VecType *x_ptr = (VecType *)x;
+
+  size_t N_elm  = sizeof(VecType)/sizeof(Real);
+  size_t N_step = (2*N)/N_elm;
+
+  // Initialize constant vectors, the imaginary part with alternating signs:
+  for (size_t i=0; i<N_elm; i+=2) {
+    a_re.d[i] = a_re.d[i+1] = a.real();
+    a_im.d[i] = -a.imag(); a_im.d[i+1] = a.imag();
+  }
+
+  // Perform operations on vectors:
+  for (size_t i=0; i<N_step; i++, x_ptr++) {
+    x_ptr->v = a_re.v * x_ptr->v + a_im.v * __simd_swap_pairs(*x_ptr).v;
+  }
+
+  // Epilogue, handle remaining elements:
+  for (size_t i=N_step*N_elm/2; i<N; i++) {
+    x[i] = __prod_ab(a, x[i]);
+  }
+}
+
+
+/**
+ * Scales a dense complex vector using SIMD vectors of @c Bytes bytes. Like
+ * @c __scal_dense_isa, a scalar prologue aligns @c x if possible.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real, size_t Bytes>
+inline void __scal_complex_dense_isa(size_t N, const std::complex<Real> &a, std::complex<Real> *x)
+{
+  // Prologue:
+  size_t P = __simd_peel<std::complex<Real>, Bytes>(x, N);
+  for (size_t i=0; i<P; i++) {
+    x[i] = __prod_ab(a, x[i]);
+  }
+  x += P; N -= P;
+
+  if (__is_simd_aligned<std::complex<Real>, Bytes>(x)) {
+    __scal_complex_dense_simd<Real, typename SIMDTraits<Real, Bytes>::auvector>(N, a, x);
+  } else {
+    __scal_complex_dense_simd<Real, typename SIMDTraits<Real, Bytes>::uvector>(N, a, x);
+  }
+}
+
+
+#ifdef LINALG_SIMD_DISPATCH
+/**
+ * Instantiates @c __scal_complex_dense_isa with AVX2 vectors, compiled for AVX2 and FMA.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX2 void
+__scal_complex_dense_avx2(size_t N, const std::complex<Real> &a, std::complex<Real> *x) {
+  __scal_complex_dense_isa<Real, 32>(N, a, x);
+}
+
+
+/**
+ * Instantiates @c __scal_complex_dense_isa with AVX-512 vectors, compiled for AVX-512F.
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+LINALG_TARGET_AVX512 void
+__scal_complex_dense_avx512(size_t N, const std::complex<Real> &a, std::complex<Real> *x) {
+  __scal_complex_dense_isa<Real, 64>(N, a, x);
+}
+#endif
+
+
+/**
+ * Scales a dense complex vector using SIMD instructions, of the instruction set selected by
+ * @c SIMD::level().
+ *
+ * @ingroup blas_internal
+ */
+template <class Real>
+inline void __scal_dense(size_t N, const std::complex<Real> &a, std::complex<Real> *x) {
+#ifdef LINALG_SIMD_DISPATCH
+  switch (SIMD::level()) {
+  case SIMD::AVX512: __scal_complex_dense_avx512(N, a, x); return;
+  case SIMD::AVX2: __scal_complex_dense_avx2(N, a, x); return;
+  default: break;
   }
+#endif
+
+  __scal_complex_dense_isa<Real, 16>(N, a, x);
 }
 
 
@@ -74,7 +247,7 @@ inline void __scal_incremental(size_t N, const Scalar &a, Scalar *x, size_t xinc
  * @ingroup blas1
  */
 template <class Scalar>
-inline void scal(const Scalar &a, Vector<Scalar> &x) {
+inline void scal(const Scalar &a, const VectorView<Scalar> &x) {
   size_t N    = x.dim();
   size_t xinc = BLAS_INCREMENT(x);
 
@@ -85,6 +258,17 @@ inline void scal(const Scalar &a, Vector<Scalar> &x) {
 }
 
 
+/**
+ * Scales a vector inplace, see above.
+ *
+ * @ingroup blas1
+ */
+template <class Scalar>
+inline void scal(const Scalar &a, Vector<Scalar> &x) {
+  scal(a, VectorView<Scalar>(x));
+}
+
+
 }
 }
 #endif // ____LINALG_BLAS_SCAL_HH__
@@ -18,6 +18,7 @@ void dtrmm_(char *side, char *uplo, char *transa, char *diag, int *m, int *n,
 
 
 #include "trimatrix.hh"
+#include "view.hh"
 #include "blas/utils.hh"
 
 
@@ -42,7 +43,7 @@ namespace Blas {
  *
  * @ingroup blas3
  */
-inline void trmm(bool left, double alpha, const TriMatrix<double> &A, Matrix<double> B)
+inline void trmm(bool left, double alpha, const TriMatrix<double> &A, const MatrixView<double> &B)
 {
   // Check dimensions:
   if (left) {
@@ -56,7 +57,7 @@ inline void trmm(bool left, double alpha, const TriMatrix<double> &A, Matrix<dou
   // Make sure, A & B are in column-major form:
   char transa = 'N', transb = 'N';
   TriMatrix<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, transa);
-  Matrix<double>    Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
+  MatrixView<double> Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
 
   // If Bcol is transposed: swap side and transpose Acol and Bcol:
   if ('T' == transb) {
@@ -9,7 +9,7 @@
 #ifndef __LINALG_BLAS_TRMV_HH__
 #define __LINALG_BLAS_TRMV_HH__
 
-#include "vector.hh"
+#include "view.hh"
 #include "trimatrix.hh"
 #include "blas/utils.hh"
 
@@ -42,14 +42,14 @@ namespace Blas {
  *
  * @ingroup blas2
  */
-inline void trmv(const Matrix<double> &A, bool upper, bool diag, Vector<double> &x)
+inline void trmv(const MatrixView<double> &A, bool upper, bool diag, const VectorView<double> &x)
 throw (ShapeError)
 {
   // Assert Acol is square:
   LINALG_SHAPE_ASSERT(A.rows() == A.cols());
   LINALG_SHAPE_ASSERT(A.rows() == x.dim());
 
-  Matrix<double> Acol = A;
+  MatrixView<double> Acol = A;
   char transa = 'N';
   // Make A column-major:
   if (A.isRowMajor()) {
@@ -62,7 +62,7 @@ throw (ShapeError)
   char uplo  = upper ? 'U' : 'L';
   char d     = diag ? 'U' : 'N';
   int  N     = Acol.cols();
-  int  lda   = Acol.strides()[1];
+  int  lda   = Acol.strides(1);
   int  incx  = BLAS_INCREMENT(x);
 
   // Call Fortran function
@@ -80,9 +80,9 @@ throw (ShapeError)
  *
  * @ingroup blas2
  */
-inline void trmv(const TriMatrix<double> &A, Vector<double> &x)
+inline void trmv(const TriMatrix<double> &A, const VectorView<double> &x)
 {
-  trmv(A, A.isUpper(), A.hasUnitDiag(), x);
+  trmv(__readonly_view(A), A.isUpper(), A.hasUnitDiag(), x);
 }
 
 
@@ -19,7 +19,7 @@ void dtrsm_(const char *SIDE, const char *UPLO, const char *TRANSA, const char *
 
 
 #include "blas/utils.hh"
-#include "matrix.hh"
+#include "view.hh"
 #include "trimatrix.hh"
 
 
@@ -35,7 +35,7 @@ namespace Blas{
  * @ingroup blas3
  */
 inline void
-trsm(const TriMatrix<double> &A, double alpha, Matrix<double> &B, bool left=true)
+trsm(const TriMatrix<double> &A, double alpha, const MatrixView<double> &B, bool left=true)
 throw (ShapeError)
 {
   // Check shapes:
@@ -49,7 +49,7 @@ throw (ShapeError)
   // Ensure A & B are column-major:
   char transa='N', transb='N';
   TriMatrix<double> Acol = A; BLAS_ENSURE_COLUMN_MAJOR(Acol, transa);
-  Matrix<double>    Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
+  MatrixView<double> Bcol = B; BLAS_ENSURE_COLUMN_MAJOR(Bcol, transb);
 
   // If B is transposed -> transpose A & B and swap side:
   char uplo = BLAS_UPLO_FLAG(Acol);
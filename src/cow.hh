@@ -0,0 +1,158 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_COW_HH__
+#define __LINALG_COW_HH__
+
+#include "array.hh"
+#include <atomic>
+
+
+namespace Linalg {
+
+/**
+ * Returns the given array as its @c Array base (used to deduce the scalar type).
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline Array<Scalar> &__as_array(Array<Scalar> &array) {
+  return array;
+}
+
+
+/**
+ * Holds the global detach counter of all @c CopyOnWrite handles.
+ *
+ * @ingroup matrix
+ */
+class CopyOnWriteStats
+{
+public:
+  /** Returns the number of copies made by all copy-on-write handles. */
+  static inline size_t detaches() {
+    return counter().load(std::memory_order_relaxed);
+  }
+
+  /** Resets the detach counter. */
+  static inline void resetDetaches() {
+    counter().store(0, std::memory_order_relaxed);
+  }
+
+protected:
+  /** Returns a reference to the global counter. */
+  static inline std::atomic<size_t> &counter() {
+    static std::atomic<size_t> count(0);
+    return count;
+  }
+};
+
+
+/**
+ * An opt-in copy-on-write handle for arrays, matrices and vectors.
+ *
+ * The handle shares the data with the array it was created from (like @c Array::operator=).
+ * Read access via @c get() never copies. The first mutable access via @c mut() creates a
+ * private copy (detach), if the data is referenced by anyone else, i.e. if the reference
+ * counter of the data is larger than one, or if the data is not owned by its manager or not
+ * writable (e.g. external data or a memory-mapped file). Hence a defensive copy before a
+ * possibly mutating call costs nothing unless something is actually written:
+ *
+ * @code
+ * CopyOnWrite< Matrix<double> > L(A);
+ * if (needs_factorization) { Lapack::potrf(L.mut(), false); } // copies A only here
+ * use(L.get());
+ * @endcode
+ *
+ * The copy keeps the storage order and the type (e.g. the flags of a @c TriMatrix). Note that
+ * the handle only protects the original data against writes through the handle; writes through
+ * other references to the data are visible through the handle until it detaches. The check of
+ * the reference counter is not synchronized with other threads taking new references to the
+ * same data.
+ *
+ * @ingroup matrix
+ */
+template <class ArrayType>
+class CopyOnWrite : public CopyOnWriteStats
+{
+protected:
+  /** The (possibly shared) array. */
+  ArrayType _array;
+  /** The number of detaches of this handle. */
+  size_t _detaches;
+
+public:
+  /** Creates a handle sharing the data of @c array. */
+  CopyOnWrite(const ArrayType &array)
+    : _array(array), _detaches(0)
+  {
+    // Pass...
+  }
+
+  /** Copy constructor, shares the data. */
+  CopyOnWrite(const CopyOnWrite<ArrayType> &other)
+    : _array(other._array), _detaches(0)
+  {
+    // Pass...
+  }
+
+  /** Assignment, shares the data. */
+  CopyOnWrite<ArrayType> &operator= (const CopyOnWrite<ArrayType> &other) {
+    _array = other._array;
+    return *this;
+  }
+
+  /** Returns read-only access to the array, never copies. */
+  inline const ArrayType &get() const {
+    return _array;
+  }
+
+  /** Implicit read-only access. */
+  inline operator const ArrayType &() const {
+    return _array;
+  }
+
+  /** Returns true if the data is shared with other references. */
+  inline bool isShared() const {
+    return 1 < _array.refCount();
+  }
+
+  /**
+   * Returns true if @c mut() writes in place, i.e. if the data is neither shared nor external
+   * nor read-only.
+   */
+  inline bool isPrivate() const {
+    auto *mngr = _array.dataManager();
+    return (0 == mngr) ||
+        ((1 == mngr->refCount()) && mngr->ownsData() && mngr->isWritable());
+  }
+
+  /**
+   * Returns mutable access to the array. Detaches (copies the data) first, if it is not
+   * private (see @c isPrivate). The returned reference must not be used to create further
+   * references to the data, that outlive the next call to @c mut().
+   */
+  inline ArrayType &mut() {
+    if (! isPrivate()) {
+      auto &base = __as_array(_array);
+      base = base.copy(base.isRowMajor());
+      _detaches++; counter().fetch_add(1, std::memory_order_relaxed);
+    }
+    return _array;
+  }
+
+  /** Returns the number of detaches of this handle. */
+  inline size_t handleDetaches() const {
+    return _detaches;
+  }
+};
+
+
+}
+
+#endif // __LINALG_COW_HH__
@@ -0,0 +1,522 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_ELEMENTWISE_HH__
+#define __LINALG_ELEMENTWISE_HH__
+
+#include "shape.hh"
+#include "openmp.hh"
+#include <algorithm>
+#include <vector>
+
+
+namespace Linalg {
+
+/**
+ * Returns the shape, the shapes @c a and @c b are broadcast to (NumPy rules): The shapes are
+ * aligned at their last dimension, missing leading dimensions are treated as size 1 and each
+ * pair of dimensions must either be equal or one of them must be 1.
+ *
+ * @throws ShapeError If the shapes are not compatible.
+ *
+ * @ingroup matrix
+ */
+inline Shape __broadcast_shape(const Shape &a, const Shape &b) throw (ShapeError)
+{
+  const Shape &l = (a.size() >= b.size()) ? a : b;
+  const Shape &s = (a.size() >= b.size()) ? b : a;
+  Shape res(l);
+
+  for (size_t i=0, off=l.size()-s.size(); i<s.size(); i++) {
+    if (s[i] == l[off+i] || 1 == s[i]) { continue; }
+    if (1 != l[off+i]) {
+      ShapeError err;
+      err << "Can not broadcast shapes: Dimension " << off+i << " of size " << l[off+i]
+          << " does not match size " << s[i] << ".";
+      throw err;
+    }
+    res[off+i] = s[i];
+  }
+
+  return res;
+}
+
+
+/**
+ * Returns the strides of an array with the given shape and strides broadcast to @c target,
+ * i.e. the strides of the broadcast dimensions are 0.
+ *
+ * @throws ShapeError If the shape can not be broadcast to @c target.
+ *
+ * @ingroup matrix
+ */
+inline Shape
+__broadcast_strides(const Shape &shape, const Shape &strides, const Shape &target)
+throw (ShapeError)
+{
+  LINALG_SHAPE_ASSERT(shape.size() <= target.size());
+
+  Shape res(target.size(), 0);
+  for (size_t i=0, off=target.size()-shape.size(); i<shape.size(); i++) {
+    if (shape[i] == target[off+i]) {
+      res[off+i] = strides[i];
+    } else if (1 != shape[i]) {
+      ShapeError err;
+      err << "Can not broadcast dimension " << i << " of size " << shape[i]
+          << " to size " << target[off+i] << ".";
+      throw err;
+    }
+  }
+
+  return res;
+}
+
+
+/**
+ * Describes a loop over all elements of @c N arrays of identical shape, with possibly different
+ * strides. Broadcast operands (see @c __broadcast_strides) have zero strides.
+ *
+ * On construction, the loop is simplified: Dimensions of size 1 are dropped and adjacent
+ * dimensions, that can be addressed with a single stride in all arrays, are merged into one.
+ * Unless the order of the elements must be kept, the dimensions are sorted by the strides of
+ * the first array first, such that row-major and column-major arrays are traversed in memory
+ * order. Hence, a dense array (or a dense sub-array in the inner dimensions) results in a
+ * single (inner) dimension with stride 1, that can be processed by a flat loop.
+ *
+ * The loop is performed by @c run, that calls a function for each line of the inner-most
+ * dimension, passing the offsets of the first element of the line for each array. Large loops
+ * are split across threads (if OpenMP is enabled).
+ *
+ * @ingroup matrix
+ */
+template <size_t N>
+class StridedLoop
+{
+protected:
+  /** The number of (simplified) dimensions. */
+  size_t _ndim;
+  /** The total number of elements. */
+  size_t _size;
+  /** The (simplified) shape. */
+  size_t _shape[LINALG_MAX_NDIM];
+  /** The (simplified) strides of each array. */
+  size_t _strides[N][LINALG_MAX_NDIM];
+
+public:
+  /**
+   * Constructs the loop over the given shape, @c strides points to the @c N strides of the
+   * arrays. If @c keep_order is true, the elements are visited in the order of the original
+   * shape (dimension 0 varies fastest), otherwise in an order that is optimal for the first
+   * array.
+   */
+  StridedLoop(const Shape &shape, const Shape *strides, bool keep_order=false)
+    : _ndim(0), _size(shape.empty() ? 0 : 1)
+  {
+    // Copy all dimensions of size != 1:
+    for (size_t i=0; i<shape.size(); i++) {
+      _size *= shape[i];
+      if (1 == shape[i]) { continue; }
+      _shape[_ndim] = shape[i];
+      for (size_t k=0; k<N; k++) { _strides[k][_ndim] = strides[k][i]; }
+      _ndim++;
+    }
+
+    // Sort dimensions by the strides of the first array (insertion sort, stable):
+    if (! keep_order) {
+      for (size_t i=1; i<_ndim; i++) {
+        for (size_t j=i; (j>0) && (_strides[0][j] < _strides[0][j-1]); j--) {
+          std::swap(_shape[j], _shape[j-1]);
+          for (size_t k=0; k<N; k++) { std::swap(_strides[k][j], _strides[k][j-1]); }
+        }
+      }
+    }
+
+    // Merge dimensions, that are contiguous in all arrays:
+    if (1 < _ndim) {
+      size_t j = 0;
+      for (size_t i=1; i<_ndim; i++) {
+        bool mergeable = true;
+        for (size_t k=0; k<N; k++) {
+          mergeable &= (_strides[k][i] == _strides[k][j]*_shape[j]);
+        }
+        if (mergeable) {
+          _shape[j] *= _shape[i];
+        } else {
+          j++; _shape[j] = _shape[i];
+          for (size_t k=0; k<N; k++) { _strides[k][j] = _strides[k][i]; }
+        }
+      }
+      _ndim = j+1;
+    }
+  }
+
+  /** Returns the number of simplified dimensions (0 if the loop has at most one element). */
+  inline size_t ndim() const { return _ndim; }
+
+  /** Returns the total number of elements. */
+  inline size_t size() const { return _size; }
+
+  /** Returns the size of the i-th simplified dimension. */
+  inline size_t shape(size_t i) const { return _shape[i]; }
+
+  /** Returns the i-th simplified stride of the k-th array. */
+  inline size_t strides(size_t k, size_t i) const { return _strides[k][i]; }
+
+  /** Returns the number of elements of the inner-most dimension. */
+  inline size_t inner() const {
+    return (0 == _ndim) ? _size : _shape[0];
+  }
+
+  /** Returns the stride of the inner-most dimension of the k-th array. */
+  inline size_t innerStride(size_t k) const {
+    return (0 == _ndim) ? 1 : _strides[k][0];
+  }
+
+  /** Returns true, if the loop consists of a single inner dimension with stride 1. */
+  inline bool isContiguous() const {
+    if (1 < _ndim) { return false; }
+    for (size_t k=0; k<N; k++) {
+      if (1 != innerStride(k)) { return false; }
+    }
+    return true;
+  }
+
+  /**
+   * Performs the loop, calls @c func(offsets, n) for each line of the inner-most dimension,
+   * where @c offsets holds the offsets of the first element of the line of each array and
+   * @c n the number of elements.
+   *
+   * If the loop is large enough (see @c OpenMP::runParallel), the elements are split into
+   * contiguous ranges, one per thread. Then lines may be split at the range boundaries and each
+   * thread calls its own copy of @c func, hence function objects with (mutable) state are safe.
+   */
+  template <class Func>
+  inline void run(Func func) const
+  {
+    if (! OpenMP::runParallel(_size)) {
+      run(func, 0, _size);
+      return;
+    }
+
+#pragma omp parallel
+    {
+      size_t begin, end;
+      partition(OpenMP::getThreadNum(), OpenMP::getNumThreads(), begin, end);
+      Func local(func);
+      run(local, begin, end);
+    }
+  }
+
+  /**
+   * Determines the range of elements [begin, end) of the i-th of @c n threads. The elements
+   * are split into equal ranges, aligned to 64 elements to avoid false sharing.
+   */
+  inline void partition(size_t i, size_t n, size_t &begin, size_t &end) const
+  {
+    size_t chunk = ((_size + n - 1)/n + 63) & ~size_t(63);
+    begin = std::min(_size, i*chunk); end = std::min(_size, begin+chunk);
+  }
+
+  /**
+   * Performs the loop serially over the elements [begin, end), where the elements are numbered
+   * in loop order.
+   */
+  template <class Func>
+  inline void run(Func &func, size_t begin, size_t end) const
+  {
+    if (begin >= end) { return; }
+
+    // Determine the position of the first element:
+    size_t n0 = inner(), first = begin % n0, rest = begin / n0;
+    size_t offsets[N], idx[LINALG_MAX_NDIM];
+    for (size_t k=0; k<N; k++) { offsets[k] = first*innerStride(k); }
+    for (size_t d=1; d<_ndim; d++) {
+      idx[d] = rest % _shape[d]; rest /= _shape[d];
+      for (size_t k=0; k<N; k++) { offsets[k] += idx[d]*_strides[k][d]; }
+    }
+
+    size_t remaining = end - begin;
+    while (true) {
+      size_t n = std::min(n0 - first, remaining);
+      func(offsets, n);
+      if (0 == (remaining -= n)) { return; }
+
+      // Back to the start of the line:
+      for (size_t k=0; k<N; k++) { offsets[k] -= first*innerStride(k); }
+      first = 0;
+
+      // Advance the outer dimensions incrementally:
+      for (size_t d=1; d<_ndim; d++) {
+        for (size_t k=0; k<N; k++) { offsets[k] += _strides[k][d]; }
+        if (++idx[d] < _shape[d]) { break; }
+        for (size_t k=0; k<N; k++) { offsets[k] -= _shape[d]*_strides[k][d]; }
+        idx[d] = 0;
+      }
+    }
+  }
+};
+
+
+/**
+ * Sets all elements of the given (strided) array to @c value.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline void
+__fill(const Shape &shape, Scalar *ptr, const Shape &strides, const Scalar &value)
+{
+  StridedLoop<1> loop(shape, &strides);
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    Scalar *p = ptr + offsets[0];
+    size_t inc = loop.innerStride(0);
+    if (1 == inc) {
+      std::fill(p, p+n, value);
+    } else {
+      for (size_t i=0; i<n; i++, p+=inc) { *p = value; }
+    }
+  });
+}
+
+
+/**
+ * Size of the tiles of the transpose kernels (elements per side), such that a source and a
+ * destination tile of doubles fit into the L1 cache.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_TRANSPOSE_TILE
+#define LINALG_TRANSPOSE_TILE 16
+#endif
+
+
+/**
+ * Copies the @c m x @c n block @c src into @c dst with the opposite storage order, i.e.
+ * @c dst[i+j*dst_ld] = src[i*src_ld+j]. The block is split recursively along its larger
+ * dimension (cache-oblivious) until it fits into a tile, that is copied by a simple loop
+ * nest, which the compiler unrolls and vectorizes along the destination.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+void
+__transpose_block(size_t m, size_t n, Scalar *dst, size_t dst_ld,
+                  const Scalar *src, size_t src_ld)
+{
+  if ((m <= LINALG_TRANSPOSE_TILE) && (n <= LINALG_TRANSPOSE_TILE)) {
+    for (size_t j=0; j<n; j++) {
+      Scalar *d = dst + j*dst_ld; const Scalar *s = src + j;
+      for (size_t i=0; i<m; i++) { d[i] = s[i*src_ld]; }
+    }
+  } else if (m >= n) {
+    size_t h = m/2;
+    __transpose_block(h, n, dst, dst_ld, src, src_ld);
+    __transpose_block(m-h, n, dst+h, dst_ld, src+h*src_ld, src_ld);
+  } else {
+    size_t h = n/2;
+    __transpose_block(m, h, dst, dst_ld, src, src_ld);
+    __transpose_block(m, n-h, dst+h*dst_ld, dst_ld, src+h, src_ld);
+  }
+}
+
+
+/**
+ * Same as @c __transpose_block, but splits large blocks into column ranges of the destination,
+ * one per thread (if OpenMP is enabled).
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline void
+__transpose_copy(size_t m, size_t n, Scalar *dst, size_t dst_ld,
+                 const Scalar *src, size_t src_ld)
+{
+  if (! OpenMP::runParallel(m*n)) {
+    __transpose_block(m, n, dst, dst_ld, src, src_ld);
+    return;
+  }
+
+#pragma omp parallel
+  {
+    size_t nt = OpenMP::getNumThreads(), t = OpenMP::getThreadNum();
+    size_t chunk = (n + nt - 1)/nt;
+    size_t begin = std::min(n, t*chunk), end = std::min(n, begin+chunk);
+    if (begin < end) {
+      __transpose_block(m, end-begin, dst+begin*dst_ld, dst_ld, src+begin, src_ld);
+    }
+  }
+}
+
+
+/**
+ * Transposes the (strided) square @c n x @c n matrix (element (i,j) at @c i*rs+j*cs)
+ * in-place, by swapping tiles across the diagonal.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+void
+__transpose_square(Scalar *data, size_t n, size_t rs, size_t cs)
+{
+  const size_t T = LINALG_TRANSPOSE_TILE;
+  for (size_t bi=0; bi<n; bi+=T) {
+    for (size_t bj=bi; bj<n; bj+=T) {
+      size_t ei = std::min(n, bi+T), ej = std::min(n, bj+T);
+      for (size_t i=bi; i<ei; i++) {
+        for (size_t j=((bi==bj) ? i+1 : bj); j<ej; j++) {
+          std::swap(data[i*rs+j*cs], data[j*rs+i*cs]);
+        }
+      }
+    }
+  }
+}
+
+
+/**
+ * Transposes the dense @c m x @c n matrix (element (i,j) at @c i*n+j) in-place into the
+ * dense @c n x @c m matrix (element (j,i) at @c j*m+i).
+ *
+ * Square matrices are transposed by @c __transpose_square. Rectangular matrices are transposed
+ * by following the cycles of the permutation @c k -> k*m mod (m*n-1), marking visited
+ * positions in a bitmap of @c m*n bits.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+void
+__transpose_inplace(Scalar *data, size_t m, size_t n)
+{
+  if ((m <= 1) || (n <= 1)) { return; }
+  if (m == n) { __transpose_square(data, n, n, 1); return; }
+
+  const size_t last = m*n - 1;
+  std::vector<bool> visited(m*n, false);
+  for (size_t start=1; start<last; start++) {
+    if (visited[start]) { continue; }
+    Scalar value = data[start];
+    size_t k = start;
+    do {
+      k = (k*m) % last;
+      std::swap(value, data[k]); visited[k] = true;
+    } while (k != start);
+  }
+}
+
+
+/**
+ * Copies all elements of the (strided) array @c src into @c dst of the same shape. If both
+ * arrays are dense and have the same storage order, a single flat copy is performed. If the
+ * storage orders differ (e.g. row-major into column-major), the copy is performed by the
+ * blocked transpose kernel (see @c __transpose_copy) over the two dimensions, that are
+ * contiguous in @c dst and @c src respectively, for all remaining dimensions.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline void
+__copy(const Shape &shape, Scalar *dst, const Shape &dst_strides,
+       const Scalar *src, const Shape &src_strides)
+{
+  Shape strides[2] = { dst_strides, src_strides };
+  StridedLoop<2> loop(shape, strides);
+
+  // Search for the dimension, the source is contiguous in, if the destination is not:
+  size_t q = 0;
+  if ((1 == loop.innerStride(0)) && (1 != loop.innerStride(1))) {
+    for (size_t d=1; (d<loop.ndim()) && (0 == q); d++) {
+      if (1 == loop.strides(1, d)) { q = d; }
+    }
+  }
+
+  if (0 != q) {
+    // Loop over all remaining dimensions, transpose a block for each element:
+    size_t m = loop.shape(0), n = loop.shape(q);
+    size_t dst_ld = loop.strides(0, q), src_ld = loop.strides(1, 0);
+    Shape outer(loop.ndim()), outer_strides[2] = { Shape(loop.ndim()), Shape(loop.ndim()) };
+    for (size_t d=0; d<loop.ndim(); d++) {
+      outer[d] = ((0 == d) || (q == d)) ? 1 : loop.shape(d);
+      outer_strides[0][d] = loop.strides(0, d); outer_strides[1][d] = loop.strides(1, d);
+    }
+    StridedLoop<2> blocks(outer, outer_strides, true);
+    blocks.run([&](const size_t *offsets, size_t count) {
+      Scalar *d = dst + offsets[0]; const Scalar *s = src + offsets[1];
+      for (size_t i=0; i<count; i++, d+=blocks.innerStride(0), s+=blocks.innerStride(1)) {
+        __transpose_copy(m, n, d, dst_ld, s, src_ld);
+      }
+    });
+    return;
+  }
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    Scalar *d = dst + offsets[0]; const Scalar *s = src + offsets[1];
+    size_t d_inc = loop.innerStride(0), s_inc = loop.innerStride(1);
+    if ((1 == d_inc) && (1 == s_inc)) {
+      std::copy(s, s+n, d);
+    } else {
+      for (size_t i=0; i<n; i++, d+=d_inc, s+=s_inc) { *d = *s; }
+    }
+  });
+}
+
+
+/**
+ * Computes @c res = op(a) element-wise for (strided) arrays of the same shape. Dense lines are
+ * processed by a flat loop, that can be vectorized by the compiler.
+ *
+ * @ingroup matrix
+ */
+template <class Res, class A, class Op>
+inline void
+__transform(const Shape &shape, Res *res, const Shape &res_strides,
+            const A *a, const Shape &a_strides, Op op)
+{
+  Shape strides[2] = { res_strides, a_strides };
+  StridedLoop<2> loop(shape, strides);
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    Res *r = res + offsets[0]; const A *x = a + offsets[1];
+    size_t r_inc = loop.innerStride(0), x_inc = loop.innerStride(1);
+    if ((1 == r_inc) && (1 == x_inc)) {
+      for (size_t i=0; i<n; i++) { r[i] = op(x[i]); }
+    } else {
+      for (size_t i=0; i<n; i++, r+=r_inc, x+=x_inc) { *r = op(*x); }
+    }
+  });
+}
+
+
+/**
+ * Computes @c res = op(a, b) element-wise for (strided) arrays of the same shape. Dense lines
+ * are processed by a flat loop, that can be vectorized by the compiler.
+ *
+ * @ingroup matrix
+ */
+template <class Res, class A, class B, class Op>
+inline void
+__transform(const Shape &shape, Res *res, const Shape &res_strides,
+            const A *a, const Shape &a_strides, const B *b, const Shape &b_strides, Op op)
+{
+  Shape strides[3] = { res_strides, a_strides, b_strides };
+  StridedLoop<3> loop(shape, strides);
+
+  loop.run([&](const size_t *offsets, size_t n) {
+    Res *r = res + offsets[0]; const A *x = a + offsets[1]; const B *y = b + offsets[2];
+    size_t r_inc = loop.innerStride(0), x_inc = loop.innerStride(1), y_inc = loop.innerStride(2);
+    if ((1 == r_inc) && (1 == x_inc) && (1 == y_inc)) {
+      for (size_t i=0; i<n; i++) { r[i] = op(x[i], y[i]); }
+    } else {
+      for (size_t i=0; i<n; i++, r+=r_inc, x+=x_inc, y+=y_inc) { *r = op(*x, *y); }
+    }
+  });
+}
+
+
+}
+
+#endif // __LINALG_ELEMENTWISE_HH__
@@ -48,6 +48,10 @@ namespace Linalg {
  */
 class Exception : public std::exception, public std::ostringstream
 {
+protected:
+  /** Holds the message returned by @c what. */
+  mutable std::string _message;
+
 public:
   /**
    * Constructs an exception with given matrix.
@@ -64,7 +68,7 @@ public:
   Exception(const Exception &other)
     : std::exception()
   {
-    (*this) << other.what();
+    (*this) << other.str();
   }
 
   /**
@@ -80,7 +84,8 @@ public:
    */
   virtual const char *what() const throw()
   {
-    return this->str().c_str();
+    _message = this->str();
+    return _message.c_str();
   }
 };
 
@@ -302,6 +307,42 @@ public:
 
 
 
+/**
+ * Will be thrown if a file can not be opened, mapped, read or written.
+ *
+ * @ingroup error
+ */
+class IOError : public RuntimeError
+{
+public:
+  /**
+   * Constructs a @c IOError exception from message.
+   */
+  IOError(const std::string &msg = "")
+    : RuntimeError(msg)
+  {
+    // Pass...
+  }
+
+  /**
+   * Copy constructor.
+   */
+  IOError(const IOError &other)
+    : RuntimeError(other)
+  {
+    // Pass...
+  }
+
+  /**
+   * Destructor.
+   */
+  virtual ~IOError() throw ()
+  {
+  }
+};
+
+
+
 /**
  * Will be thrown if an argument to a LAPACK function is invalid.
  *
@@ -0,0 +1,469 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_EXPRESSION_HH__
+#define __LINALG_EXPRESSION_HH__
+
+#include "array.hh"
+#include "elementwise.hh"
+#include <utility>
+#include <type_traits>
+
+
+namespace Linalg {
+
+/**
+ * Base class of all lazy element-wise expressions over arrays, matrices and vectors.
+ *
+ * The element-wise operators @c +, @c - (binary and unary), @c mul and @c div, the scaling by
+ * a scalar @c * and @c / and @c apply do not compute anything, they return an expression object, that holds
+ * (shared) references to the operands. The expression is evaluated in a single fused pass
+ * over all operands, when it is assigned to the values of an array or converted into a new
+ * @c Array, @c Matrix or @c Vector:
+ *
+ * @code
+ * Matrix<double> A(n,m), B(n,m), C(n,m), D(n,m);
+ * D.values() = A + B - 2.0*C;   // no temporaries, one pass
+ * Matrix<double> E = A - B;     // allocates E only
+ * @endcode
+ *
+ * The operands of an expression are broadcast (see @c Array::broadcast), e.g. a vector is
+ * added to each row of a matrix and @c x.expand(1) scales each row by the corresponding
+ * element of @c x, without any temporary. A @c ShapeError is thrown if the shapes are not
+ * compatible. The destination must not overlap with an operand, unless it is the identical
+ * array (e.g. @c A.values() = A + B is fine, @c A.values() = A.t() + B is not).
+ *
+ * The matrix product @c * accepts expressions as operands and evaluates them into temporary
+ * matrices (e.g. @c A*(B+C)). The BLAS wrappers expect matrices and vectors, hence an
+ * expression has to be evaluated explicitly there, e.g. @c Blas::gemv(1., A, Vector<double>(x+y),
+ * 0., z).
+ *
+ * Each expression type provides the following interface:
+ * - @c value_type, the type of the elements,
+ * - @c leaves, the number of array operands,
+ * - @c shape(), the (broadcast) shape of the result,
+ * - @c isRowMajor(), the storage order of the first operand,
+ * - @c bind(shape, strides, k), registers the strides of all operands broadcast to the given
+ *   shape in the given array, starting at index @c k,
+ * - @c line(offsets, loop), moves all operands to the line of the loop at the given offsets,
+ * - @c dense(i) and @c strided(i), evaluates the i-th element of the current line, for
+ *   contiguous and strided lines respectively.
+ *
+ * @ingroup operators
+ */
+template <class Derived>
+class ArrayExpr
+{
+public:
+  /** Returns the actual expression. */
+  inline const Derived &derived() const {
+    return static_cast<const Derived &>(*this);
+  }
+
+  /** Returns the shape of the result. */
+  inline const Shape &shape() const {
+    return derived().shape();
+  }
+};
+
+
+/**
+ * An expression holding an array operand.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+class ArrayLeafExpr : public ArrayExpr< ArrayLeafExpr<Scalar> >
+{
+public:
+  /** The element type. */
+  typedef Scalar value_type;
+  /** The number of array operands. */
+  static const size_t leaves = 1;
+
+protected:
+  /** The operand, shares the data. */
+  Array<Scalar> _array;
+  /** The index of the operand in the loop. */
+  size_t _k;
+  /** Pointer to the current line. */
+  const Scalar *_line;
+  /** The stride of the current line. */
+  size_t _inc;
+
+public:
+  /** Constructor. */
+  ArrayLeafExpr(const Array<Scalar> &array)
+    : _array(array), _k(0), _line(0), _inc(1)
+  {
+    // Pass...
+  }
+
+  /** Copy constructor. */
+  ArrayLeafExpr(const ArrayLeafExpr<Scalar> &other)
+    : _array(other._array), _k(other._k), _line(other._line), _inc(other._inc)
+  {
+    // Pass...
+  }
+
+  inline const Shape &shape() const { return _array.shape(); }
+  inline bool isRowMajor() const { return _array.isRowMajor(); }
+
+  inline void bind(const Shape &shape, Shape *strides, size_t &k) {
+    _k = k; strides[k++] = __broadcast_strides(_array.shape(), _array.strides(), shape);
+  }
+
+  template <size_t N>
+  inline void line(const size_t *offsets, const StridedLoop<N> &loop) {
+    _line = _array.ptr() + offsets[_k]; _inc = loop.innerStride(_k);
+  }
+
+  inline Scalar dense(size_t i) const { return _line[i]; }
+  inline Scalar strided(size_t i) const { return _line[i*_inc]; }
+};
+
+
+/**
+ * An expression applying a unary function object element-wise.
+ *
+ * @ingroup operators
+ */
+template <class Op, class Expr>
+class ArrayUnaryExpr : public ArrayExpr< ArrayUnaryExpr<Op, Expr> >
+{
+public:
+  /** The element type. */
+  typedef typename std::decay<
+  decltype(std::declval<Op>()(std::declval<typename Expr::value_type>()))>::type value_type;
+  /** The number of array operands. */
+  static const size_t leaves = Expr::leaves;
+
+protected:
+  /** The operand. */
+  Expr _expr;
+  /** The function. */
+  Op _op;
+
+public:
+  /** Constructor. */
+  ArrayUnaryExpr(const Expr &expr, const Op &op)
+    : _expr(expr), _op(op)
+  {
+    // Pass...
+  }
+
+  inline const Shape &shape() const { return _expr.shape(); }
+  inline bool isRowMajor() const { return _expr.isRowMajor(); }
+
+  inline void bind(const Shape &shape, Shape *strides, size_t &k) {
+    _expr.bind(shape, strides, k);
+  }
+
+  template <size_t N>
+  inline void line(const size_t *offsets, const StridedLoop<N> &loop) {
+    _expr.line(offsets, loop);
+  }
+
+  inline value_type dense(size_t i) const { return _op(_expr.dense(i)); }
+  inline value_type strided(size_t i) const { return _op(_expr.strided(i)); }
+};
+
+
+/**
+ * An expression combining two expressions element-wise.
+ *
+ * @ingroup operators
+ */
+template <class Op, class Lhs, class Rhs>
+class ArrayBinaryExpr : public ArrayExpr< ArrayBinaryExpr<Op, Lhs, Rhs> >
+{
+public:
+  /** The element type. */
+  typedef typename std::decay<
+  decltype(std::declval<Op>()(std::declval<typename Lhs::value_type>(),
+                              std::declval<typename Rhs::value_type>()))>::type value_type;
+  /** The number of array operands. */
+  static const size_t leaves = Lhs::leaves + Rhs::leaves;
+
+protected:
+  /** The left operand. */
+  Lhs _lhs;
+  /** The right operand. */
+  Rhs _rhs;
+  /** The function. */
+  Op _op;
+  /** The shape, both operands are broadcast to. */
+  Shape _shape;
+
+public:
+  /**
+   * Constructor.
+   *
+   * @throws ShapeError If the shapes of the operands can not be broadcast.
+   */
+  ArrayBinaryExpr(const Lhs &lhs, const Rhs &rhs, const Op &op)
+    : _lhs(lhs), _rhs(rhs), _op(op), _shape(__broadcast_shape(lhs.shape(), rhs.shape()))
+  {
+    // Pass...
+  }
+
+  inline const Shape &shape() const { return _shape; }
+  inline bool isRowMajor() const { return _lhs.isRowMajor(); }
+
+  inline void bind(const Shape &shape, Shape *strides, size_t &k) {
+    _lhs.bind(shape, strides, k); _rhs.bind(shape, strides, k);
+  }
+
+  template <size_t N>
+  inline void line(const size_t *offsets, const StridedLoop<N> &loop) {
+    _lhs.line(offsets, loop); _rhs.line(offsets, loop);
+  }
+
+  inline value_type dense(size_t i) const { return _op(_lhs.dense(i), _rhs.dense(i)); }
+  inline value_type strided(size_t i) const { return _op(_lhs.strided(i), _rhs.strided(i)); }
+};
+
+
+/**
+ * Evaluates the given expression into the (strided) destination of the same shape, in a single
+ * pass. Contiguous lines are evaluated by a flat loop, that can be vectorized by the compiler.
+ *
+ * @throws ShapeError If the expression can not be broadcast to the shape of the destination.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, class Expr>
+inline void
+__evaluate(const Shape &shape, Scalar *dst, const Shape &dst_strides, const ArrayExpr<Expr> &expr)
+throw (ShapeError)
+{
+  LINALG_SHAPE_ASSERT(shape == __broadcast_shape(shape, expr.shape()));
+
+  // Bind a copy of the expression to the loop:
+  const size_t N = Expr::leaves + 1;
+  Expr e(expr.derived());
+  Shape strides[N]; strides[0] = dst_strides;
+  size_t k = 1; e.bind(shape, strides, k);
+  StridedLoop<N> loop(shape, strides);
+
+  bool dense = true;
+  for (size_t i=0; i<N; i++) { dense &= (1 == loop.innerStride(i)); }
+  size_t inc = loop.innerStride(0);
+
+  // The expression holds the state of the current line, hence each thread needs its own copy:
+  loop.run([e, dst, dense, inc, &loop](const size_t *offsets, size_t n) mutable {
+    Scalar *r = dst + offsets[0];
+    e.line(offsets, loop);
+    if (dense) {
+      for (size_t i=0; i<n; i++) { r[i] = e.dense(i); }
+    } else {
+      for (size_t i=0; i<n; i++, r+=inc) { *r = e.strided(i); }
+    }
+  });
+}
+
+
+/** Element-wise sum. */
+struct __expr_add {
+  template <class A, class B>
+  inline auto operator() (const A &a, const B &b) const -> decltype(a+b) { return a+b; }
+};
+
+/** Element-wise difference. */
+struct __expr_sub {
+  template <class A, class B>
+  inline auto operator() (const A &a, const B &b) const -> decltype(a-b) { return a-b; }
+};
+
+/** Element-wise product. */
+struct __expr_mul {
+  template <class A, class B>
+  inline auto operator() (const A &a, const B &b) const -> decltype(a*b) { return a*b; }
+};
+
+/** Element-wise quotient. */
+struct __expr_quot {
+  template <class A, class B>
+  inline auto operator() (const A &a, const B &b) const -> decltype(a/b) { return a/b; }
+};
+
+/** Element-wise negation. */
+struct __expr_neg {
+  template <class A>
+  inline auto operator() (const A &a) const -> decltype(-a) { return -a; }
+};
+
+/** Element-wise scaling. */
+template <class Scalar>
+struct __expr_scale {
+  Scalar alpha;
+  inline Scalar operator() (const Scalar &a) const { return a*alpha; }
+};
+
+/** Element-wise division by a scalar. */
+template <class Scalar>
+struct __expr_div {
+  Scalar alpha;
+  inline Scalar operator() (const Scalar &a) const { return a/alpha; }
+};
+
+
+/**
+ * Defines the element-wise binary operator @c OP (as function object @c FUNC) for all
+ * combinations of arrays and expressions.
+ */
+#define LINALG_EXPR_BINARY_OPERATOR(OP, FUNC) \
+template <class L, class R> \
+inline ArrayBinaryExpr<FUNC, L, R> \
+OP (const ArrayExpr<L> &lhs, const ArrayExpr<R> &rhs) { \
+  return ArrayBinaryExpr<FUNC, L, R>(lhs.derived(), rhs.derived(), FUNC()); \
+} \
+template <class L, class Scalar> \
+inline ArrayBinaryExpr<FUNC, L, ArrayLeafExpr<Scalar> > \
+OP (const ArrayExpr<L> &lhs, const Array<Scalar> &rhs) { \
+  return ArrayBinaryExpr<FUNC, L, ArrayLeafExpr<Scalar> >(lhs.derived(), rhs, FUNC()); \
+} \
+template <class Scalar, class R> \
+inline ArrayBinaryExpr<FUNC, ArrayLeafExpr<Scalar>, R> \
+OP (const Array<Scalar> &lhs, const ArrayExpr<R> &rhs) { \
+  return ArrayBinaryExpr<FUNC, ArrayLeafExpr<Scalar>, R>(lhs, rhs.derived(), FUNC()); \
+} \
+template <class Scalar> \
+inline ArrayBinaryExpr<FUNC, ArrayLeafExpr<Scalar>, ArrayLeafExpr<Scalar> > \
+OP (const Array<Scalar> &lhs, const Array<Scalar> &rhs) { \
+  return ArrayBinaryExpr<FUNC, ArrayLeafExpr<Scalar>, ArrayLeafExpr<Scalar> >(lhs, rhs, FUNC()); \
+}
+
+/**
+ * Element-wise sum of arrays, matrices, vectors and expressions.
+ *
+ * @ingroup operators
+ */
+LINALG_EXPR_BINARY_OPERATOR(operator+, __expr_add)
+
+/**
+ * Element-wise difference of arrays, matrices, vectors and expressions.
+ *
+ * @ingroup operators
+ */
+LINALG_EXPR_BINARY_OPERATOR(operator-, __expr_sub)
+
+/**
+ * Element-wise (Hadamard) product of arrays, matrices, vectors and expressions. Note that
+ * @c operator* of two matrices is the matrix product.
+ *
+ * @ingroup operators
+ */
+LINALG_EXPR_BINARY_OPERATOR(mul, __expr_mul)
+
+/**
+ * Element-wise quotient of arrays, matrices, vectors and expressions.
+ *
+ * @ingroup operators
+ */
+LINALG_EXPR_BINARY_OPERATOR(div, __expr_quot)
+
+#undef LINALG_EXPR_BINARY_OPERATOR
+
+
+/**
+ * Applies the function object @c func element-wise to an array or expression.
+ *
+ * @code
+ * B.values() = apply(A, [](double x) { return std::sqrt(x); });
+ * @endcode
+ *
+ * @ingroup operators
+ */
+template <class T, class Op>
+inline ArrayUnaryExpr<Op, T>
+apply(const ArrayExpr<T> &expr, const Op &func) {
+  return ArrayUnaryExpr<Op, T>(expr.derived(), func);
+}
+
+/** Applies the function object @c func element-wise to an array. */
+template <class Scalar, class Op>
+inline ArrayUnaryExpr<Op, ArrayLeafExpr<Scalar> >
+apply(const Array<Scalar> &array, const Op &func) {
+  return ArrayUnaryExpr<Op, ArrayLeafExpr<Scalar> >(array, func);
+}
+
+
+/**
+ * Element-wise negation.
+ *
+ * @ingroup operators
+ */
+template <class T>
+inline ArrayUnaryExpr<__expr_neg, T>
+operator- (const ArrayExpr<T> &expr) { return apply(expr, __expr_neg()); }
+
+/** Element-wise negation. */
+template <class Scalar>
+inline ArrayUnaryExpr<__expr_neg, ArrayLeafExpr<Scalar> >
+operator- (const Array<Scalar> &array) { return apply(array, __expr_neg()); }
+
+
+/**
+ * Scaling of an expression by a scalar.
+ *
+ * @ingroup operators
+ */
+template <class T>
+inline ArrayUnaryExpr<__expr_scale<typename T::value_type>, T>
+operator* (const ArrayExpr<T> &expr, const typename T::value_type &alpha) {
+  __expr_scale<typename T::value_type> op = { alpha };
+  return apply(expr, op);
+}
+
+/** Scaling of an expression by a scalar. */
+template <class T>
+inline ArrayUnaryExpr<__expr_scale<typename T::value_type>, T>
+operator* (const typename T::value_type &alpha, const ArrayExpr<T> &expr) {
+  return expr*alpha;
+}
+
+/** Division of an expression by a scalar. */
+template <class T>
+inline ArrayUnaryExpr<__expr_div<typename T::value_type>, T>
+operator/ (const ArrayExpr<T> &expr, const typename T::value_type &alpha) {
+  __expr_div<typename T::value_type> op = { alpha };
+  return apply(expr, op);
+}
+
+/**
+ * Scaling of an array by a scalar.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline ArrayUnaryExpr<__expr_scale<Scalar>, ArrayLeafExpr<Scalar> >
+operator* (const Array<Scalar> &array, const Scalar &alpha) {
+  __expr_scale<Scalar> op = { alpha };
+  return apply(array, op);
+}
+
+/** Scaling of an array by a scalar. */
+template <class Scalar>
+inline ArrayUnaryExpr<__expr_scale<Scalar>, ArrayLeafExpr<Scalar> >
+operator* (const Scalar &alpha, const Array<Scalar> &array) {
+  return array*alpha;
+}
+
+/** Division of an array by a scalar. */
+template <class Scalar>
+inline ArrayUnaryExpr<__expr_div<Scalar>, ArrayLeafExpr<Scalar> >
+operator/ (const Array<Scalar> &array, const Scalar &alpha) {
+  __expr_div<Scalar> op = { alpha };
+  return apply(array, op);
+}
+
+
+}
+
+#endif // __LINALG_EXPRESSION_HH__
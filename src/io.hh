@@ -0,0 +1,498 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_IO_HH__
+#define __LINALG_IO_HH__
+
+#include "matrix.hh"
+#include "vector.hh"
+#include "trimatrix.hh"
+#include "mapped.hh"
+#include <fstream>
+#include <vector>
+#include <complex>
+#include <cstring>
+#include <limits>
+#include <stdint.h>
+
+
+namespace Linalg {
+
+/**
+ * Type codes of the binary format, see @c BinaryHeader.
+ *
+ * @ingroup io
+ */
+typedef enum {
+  DTYPE_FLOAT = 1,           ///< float
+  DTYPE_DOUBLE = 2,          ///< double
+  DTYPE_COMPLEX_FLOAT = 3,   ///< std::complex<float>
+  DTYPE_COMPLEX_DOUBLE = 4   ///< std::complex<double>
+} BinaryDType;
+
+/** Maps a scalar type to its @c BinaryDType. */
+template <class Scalar> struct __binary_dtype { };
+/** Maps a scalar type to its @c BinaryDType. */
+template <> struct __binary_dtype<float> { static const uint32_t code = DTYPE_FLOAT; };
+/** Maps a scalar type to its @c BinaryDType. */
+template <> struct __binary_dtype<double> { static const uint32_t code = DTYPE_DOUBLE; };
+/** Maps a scalar type to its @c BinaryDType. */
+template <> struct __binary_dtype< std::complex<float> > {
+  static const uint32_t code = DTYPE_COMPLEX_FLOAT; };
+/** Maps a scalar type to its @c BinaryDType. */
+template <> struct __binary_dtype< std::complex<double> > {
+  static const uint32_t code = DTYPE_COMPLEX_DOUBLE; };
+
+
+/**
+ * The header of a record in a binary container file.
+ *
+ * A container file is a sequence of records. Each record consists of this 64-byte header
+ * followed by the payload, padded to a multiple of 64 bytes. Hence every payload starts at a
+ * 64-byte boundary of the file and can be mapped directly (see @c BinaryReader). All values are
+ * stored in the native byte order, which is checked by @c byte_order on load.
+ *
+ * @ingroup io
+ */
+struct BinaryHeader
+{
+  /** Format version. */
+  static const uint32_t current_version = 1;
+  /** Alignment of the payloads (in bytes) within the file, equals the header size. */
+  static const uint64_t alignment = 64;
+  /** Flag: The payload is stored row-major (C order). */
+  static const uint32_t ROW_MAJOR = 1;
+  /** Flag: The record holds a triangular matrix. */
+  static const uint32_t TRIANGULAR = 2;
+  /** Flag: The triangular matrix is upper-triangular. */
+  static const uint32_t UPPER = 4;
+  /** Flag: The triangular matrix has an implicit unit diagonal. */
+  static const uint32_t UNIT_DIAG = 8;
+
+  /** Magic bytes "LINALG" followed by two zeros. */
+  char magic[8];
+  /** The format version. */
+  uint32_t version;
+  /** Byte-order mark, 0x01020304 in the byte order of the writer. */
+  uint32_t byte_order;
+  /** The element type, see @c BinaryDType. */
+  uint32_t dtype;
+  /** The size of a single element in bytes. */
+  uint32_t element_size;
+  /** The number of dimensions (1 or 2). */
+  uint32_t ndim;
+  /** Combination of the flags above. */
+  uint32_t flags;
+  /** The shape. */
+  uint64_t shape[2];
+  /** The strides (in elements) of the payload. */
+  uint64_t strides[2];
+
+  /** Returns the number of elements of the payload. */
+  inline uint64_t size() const {
+    return (1 == ndim) ? shape[0] : shape[0]*shape[1];
+  }
+
+  /**
+   * Returns the size of the padded payload in bytes. Only meaningful for valid headers, see
+   * @c isValid.
+   */
+  inline uint64_t payloadSize() const {
+    return ((size()*element_size + alignment - 1)/alignment)*alignment;
+  }
+
+  /** Returns the size of an element of the given @c BinaryDType in bytes, 0 if unknown. */
+  static inline uint32_t elementSize(uint32_t dtype) {
+    switch (dtype) {
+    case DTYPE_FLOAT: return sizeof(float);
+    case DTYPE_DOUBLE: return sizeof(double);
+    case DTYPE_COMPLEX_FLOAT: return sizeof(std::complex<float>);
+    case DTYPE_COMPLEX_DOUBLE: return sizeof(std::complex<double>);
+    default: break;
+    }
+    return 0;
+  }
+
+  /** Returns a header for the given scalar type, number of dimensions and flags. */
+  template <class Scalar>
+  static BinaryHeader create(uint32_t ndim, uint32_t flags)
+  {
+    BinaryHeader header; std::memset(&header, 0, sizeof(BinaryHeader));
+    std::memcpy(header.magic, "LINALG\0\0", 8);
+    header.version      = current_version;
+    header.byte_order   = 0x01020304;
+    header.dtype        = __binary_dtype<Scalar>::code;
+    header.element_size = sizeof(Scalar);
+    header.ndim         = ndim;
+    header.flags        = flags;
+    return header;
+  }
+
+  /**
+   * Returns true if the magic bytes, the version, the byte order, the type and the shape are
+   * valid, i.e. if the (padded) payload size does not overflow and the strides are the
+   * contiguous ones of the shape and storage order.
+   */
+  inline bool isValid() const {
+    if ((0 != std::memcmp(magic, "LINALG\0\0", 8)) || (current_version < version) ||
+        (0x01020304 != byte_order) || (1 > ndim) || (2 < ndim)) {
+      return false;
+    }
+    if ((0 == element_size) || (elementSize(dtype) != element_size)) {
+      return false;
+    }
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    if ((2 == ndim) && (0 != shape[1]) && (shape[0] > max/shape[1])) {
+      return false;
+    }
+    if (size() > (max - alignment)/element_size) {
+      return false;
+    }
+    if (1 == ndim) {
+      return 1 == strides[0];
+    }
+    if (0 != (flags & ROW_MAJOR)) {
+      return (shape[1] == strides[0]) && (1 == strides[1]);
+    }
+    return (1 == strides[0]) && (shape[0] == strides[1]);
+  }
+};
+
+
+
+/**
+ * Writes matrices, vectors and triangular matrices as records to a binary container file.
+ *
+ * Each array is written contiguously in its own storage order (arrays, that are neither row-
+ * nor column-contiguous, are written row-major).
+ *
+ * @code
+ * BinaryWriter out("qr.bin");
+ * out.write(A); out.write(tau);
+ * @endcode
+ *
+ * @ingroup io
+ */
+class BinaryWriter
+{
+protected:
+  /** The output stream. */
+  std::ofstream _stream;
+  /** The filename. */
+  std::string _filename;
+
+public:
+  /**
+   * Creates (or truncates) the given file.
+   *
+   * @throws IOError If the file can not be created.
+   */
+  BinaryWriter(const std::string &filename) throw (IOError)
+    : _stream(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+      _filename(filename)
+  {
+    if (! _stream.good()) {
+      IOError err;
+      err << "Can not create file " << filename << ".";
+      throw err;
+    }
+  }
+
+  /** Writes a matrix record. */
+  template <class Scalar>
+  void write(const Matrix<Scalar> &A) throw (IOError) {
+    writeMatrix(A, 0);
+  }
+
+  /** Writes a triangular matrix record. */
+  template <class Scalar>
+  void write(const TriMatrix<Scalar> &A) throw (IOError) {
+    writeMatrix(A, BinaryHeader::TRIANGULAR | (A.isUpper() ? BinaryHeader::UPPER : 0) |
+                (A.hasUnitDiag() ? BinaryHeader::UNIT_DIAG : 0));
+  }
+
+  /** Writes a vector record. */
+  template <class Scalar>
+  void write(const Vector<Scalar> &x) throw (IOError)
+  {
+    BinaryHeader header = BinaryHeader::create<Scalar>(1, BinaryHeader::ROW_MAJOR);
+    header.shape[0] = x.dim(); header.strides[0] = 1;
+    writeHeader(header);
+
+    if (1 == x.stride()) {
+      writeData(x.ptr(), x.dim());
+    } else {
+      for (size_t i=0; i<x.dim(); i++) { writeData(&x(i), 1); }
+    }
+    writePadding(header);
+  }
+
+  /** Flushes the stream. */
+  void flush() throw (IOError) {
+    _stream.flush(); check();
+  }
+
+
+protected:
+  /** Writes a (triangular) matrix record with the given flags. */
+  template <class Scalar>
+  void writeMatrix(const Matrix<Scalar> &A, uint32_t flags) throw (IOError)
+  {
+    size_t rows = A.rows(), cols = A.cols();
+    bool rowmajor = (1 == A.strides(1)) || (1 != A.strides(0));
+    BinaryHeader header = BinaryHeader::create<Scalar>(
+          2, flags | (rowmajor ? BinaryHeader::ROW_MAJOR : 0));
+    header.shape[0] = rows; header.shape[1] = cols;
+    header.strides[0] = rowmajor ? cols : 1; header.strides[1] = rowmajor ? 1 : rows;
+    writeHeader(header);
+
+    // Write rows (row-major) or columns (column-major):
+    size_t outer = rowmajor ? rows : cols, inner = rowmajor ? cols : rows;
+    for (size_t i=0; i<outer; i++) {
+      if (1 == A.strides(rowmajor ? 1 : 0)) {
+        writeData(rowmajor ? &A(i,0) : &A(0,i), inner);
+      } else {
+        for (size_t j=0; j<inner; j++) { writeData(rowmajor ? &A(i,j) : &A(j,i), 1); }
+      }
+    }
+    writePadding(header);
+  }
+
+  /** Writes the header. */
+  void writeHeader(const BinaryHeader &header) throw (IOError) {
+    _stream.write(reinterpret_cast<const char *>(&header), sizeof(BinaryHeader)); check();
+  }
+
+  /** Writes @c n elements. */
+  template <class Scalar>
+  void writeData(const Scalar *data, size_t n) throw (IOError) {
+    _stream.write(reinterpret_cast<const char *>(data), n*sizeof(Scalar)); check();
+  }
+
+  /** Pads the payload to a multiple of @c BinaryHeader::alignment bytes. */
+  void writePadding(const BinaryHeader &header) throw (IOError) {
+    static const char zeros[BinaryHeader::alignment] = {0};
+    _stream.write(zeros, header.payloadSize() - header.size()*header.element_size); check();
+  }
+
+  /** Checks the stream state. */
+  void check() throw (IOError) {
+    if (! _stream.good()) {
+      IOError err;
+      err << "Can not write to file " << _filename << ".";
+      throw err;
+    }
+  }
+};
+
+
+
+/**
+ * Reads a binary container file written by @c BinaryWriter.
+ *
+ * The reader only parses the record headers. The payloads are mapped into memory on request
+ * (zero-copy), hence loading a record takes constant time independent of its size. The returned
+ * matrices and vectors keep the mapping alive. By default, the file is mapped read-only and
+ * writing to the returned arrays results in a segmentation fault; use @c copy() to obtain a
+ * writable copy or open the file as writable to modify the file in place.
+ *
+ * @ingroup io
+ */
+class BinaryReader
+{
+protected:
+  /** The filename. */
+  std::string _filename;
+  /** If true, the records are mapped read-write. */
+  bool _writable;
+  /** The record headers. */
+  std::vector<BinaryHeader> _headers;
+  /** The payload offsets of the records. */
+  std::vector<uint64_t> _offsets;
+
+public:
+  /**
+   * Opens the given file and reads the record headers. If @c writable is true, the records are
+   * mapped read-write and changes to the returned arrays are written back to the file.
+   *
+   * @throws IOError If the file can not be read or is not a valid container file.
+   */
+  BinaryReader(const std::string &filename, bool writable=false)
+  throw (IOError)
+    : _filename(filename), _writable(writable)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (! stream.good()) {
+      IOError err;
+      err << "Can not open file " << filename << ".";
+      throw err;
+    }
+
+    stream.seekg(0, std::ios::end);
+    uint64_t file_size = stream.tellg();
+
+    uint64_t offset = 0;
+    while (offset < file_size) {
+      BinaryHeader header;
+      stream.seekg(offset);
+      stream.read(reinterpret_cast<char *>(&header), sizeof(BinaryHeader));
+      if ((! stream.good()) || (! header.isValid()) ||
+          (header.payloadSize() > file_size - offset - sizeof(BinaryHeader))) {
+        IOError err;
+        err << "Invalid record at offset " << offset << " in file " << filename << ".";
+        throw err;
+      }
+      _headers.push_back(header);
+      _offsets.push_back(offset + sizeof(BinaryHeader));
+      offset += sizeof(BinaryHeader) + header.payloadSize();
+    }
+  }
+
+  /** Returns the number of records. */
+  inline size_t count() const { return _headers.size(); }
+
+  /** Returns the header of the i-th record. */
+  inline const BinaryHeader &header(size_t i) const { return _headers[i]; }
+
+  /**
+   * Maps the i-th record as a matrix (a vector record is returned as a column vector). An empty
+   * record is returned as an (unmapped) empty matrix of the same shape.
+   *
+   * @throws IOError If the record does not exist, can not be mapped or has a different type.
+   */
+  template <class Scalar>
+  Matrix<Scalar> matrix(size_t i) throw (IOError)
+  {
+    const BinaryHeader &h = checkHeader<Scalar>(i);
+
+    Shape dims(2), strd(2);
+    if (1 == h.ndim) {
+      dims[0] = h.shape[0]; dims[1] = 1; strd[0] = h.strides[0]; strd[1] = h.shape[0];
+    } else {
+      dims[0] = h.shape[0]; dims[1] = h.shape[1]; strd[0] = h.strides[0]; strd[1] = h.strides[1];
+    }
+
+    if (0 == h.size()) {
+      return Matrix<Scalar>::empty(dims[0], dims[1], 0 != (h.flags & BinaryHeader::ROW_MAJOR));
+    }
+    return Matrix<Scalar>(Array<Scalar>(DataPtr<Scalar>(map<Scalar>(i)), 0, dims, strd));
+  }
+
+  /**
+   * Maps the i-th record as a triangular matrix. The flags are taken from the record, a
+   * non-triangular record is interpreted as upper-triangular.
+   *
+   * @throws IOError If the record does not exist, can not be mapped or has a different type.
+   */
+  template <class Scalar>
+  TriMatrix<Scalar> triMatrix(size_t i) throw (IOError)
+  {
+    uint32_t flags = checkHeader<Scalar>(i).flags;
+    return TriMatrix<Scalar>(matrix<Scalar>(i), (0 == (flags & BinaryHeader::TRIANGULAR)) ||
+                             (0 != (flags & BinaryHeader::UPPER)),
+                             0 != (flags & BinaryHeader::UNIT_DIAG));
+  }
+
+  /**
+   * Maps the i-th record as a vector. Matrix records are flattened in storage order. An empty
+   * record is returned as an (unmapped) empty vector.
+   *
+   * @throws IOError If the record does not exist, can not be mapped or has a different type.
+   */
+  template <class Scalar>
+  Vector<Scalar> vector(size_t i) throw (IOError)
+  {
+    if (0 == checkHeader<Scalar>(i).size()) {
+      return Vector<Scalar>::empty(0);
+    }
+    return mapVector(map<Scalar>(i));
+  }
+
+
+protected:
+  /** Maps the payload of the i-th record, which must not be empty. */
+  template <class Scalar>
+  MappedDataMngr<Scalar> *map(size_t i) throw (IOError)
+  {
+    return MappedDataMngr<Scalar>::open(
+          _filename, _writable ? MappedDataMngr<Scalar>::READ_WRITE : MappedDataMngr<Scalar>::READ_ONLY,
+          _offsets[i], _headers[i].size());
+  }
+
+  /** Checks the index and type of the i-th record. */
+  template <class Scalar>
+  const BinaryHeader &checkHeader(size_t i) throw (IOError)
+  {
+    if (i >= _headers.size()) {
+      IOError err;
+      err << "Can not read record " << i << " from file " << _filename << ": Only "
+          << _headers.size() << " records found.";
+      throw err;
+    }
+
+    const BinaryHeader &h = _headers[i];
+    if ((__binary_dtype<Scalar>::code != h.dtype) || (sizeof(Scalar) != h.element_size)) {
+      IOError err;
+      err << "Can not read record " << i << " from file " << _filename
+          << ": Type mismatch (stored type " << h.dtype << ").";
+      throw err;
+    }
+
+    return h;
+  }
+};
+
+
+
+/**
+ * Saves a single matrix, triangular matrix or vector to the given file.
+ *
+ * @throws IOError If the file can not be written.
+ *
+ * @ingroup io
+ */
+template <class ArrayType>
+inline void save(const std::string &filename, const ArrayType &array) throw (IOError)
+{
+  BinaryWriter writer(filename);
+  writer.write(array);
+  writer.flush();
+}
+
+
+/**
+ * Loads (maps) the first record of the given file as a matrix.
+ *
+ * @throws IOError If the file can not be read.
+ *
+ * @ingroup io
+ */
+template <class Scalar>
+inline Matrix<Scalar> loadMatrix(const std::string &filename) throw (IOError)
+{
+  return BinaryReader(filename).matrix<Scalar>(0);
+}
+
+
+/**
+ * Loads (maps) the first record of the given file as a vector.
+ *
+ * @throws IOError If the file can not be read.
+ *
+ * @ingroup io
+ */
+template <class Scalar>
+inline Vector<Scalar> loadVector(const std::string &filename) throw (IOError)
+{
+  return BinaryReader(filename).vector<Scalar>(0);
+}
+
+
+}
+
+#endif // __LINALG_IO_HH__
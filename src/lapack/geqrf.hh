@@ -1,11 +1,11 @@
 #ifndef __LINALG_LAPACK_GEQRF_HH__
 #define __LINALG_LAPACK_GEQRF_HH__
 
-#include "matrix.hh"
-#include "vector.hh"
+#include "view.hh"
 #include "blas/dot.hh"
 #include "blas/axpy.hh"
-#include "operators.hh"
+#include "blas/nrm2.hh"
+#include "blas/scal.hh"
 
 #include "openmp.hh"
 
@@ -20,7 +20,7 @@ namespace Lapack {
  * @ingroup lapack_internal
  */
 inline void
-__prod_householder(const Vector<double> &v, Vector<double> &a)
+__prod_householder(const VectorView<double> &v, const VectorView<double> &a)
 throw (ShapeError)
 {
   double scale = -2*Blas::dot(v,a);
@@ -34,17 +34,31 @@ throw (ShapeError)
  * @ingroup lapack_internal
  */
 inline void
-__prod_householder(const Vector<double> &v, Matrix<double> &A)
+__prod_householder(const VectorView<double> &v, const MatrixView<double> &A)
 throw (ShapeError)
 {
-  Vector<double> a;
   for(size_t j=0; j<A.cols(); j++) {
-    a = A.col(j);
-    __prod_householder(v, a);
+    __prod_householder(v, A.col(j));
   }
 }
 
 
+/**
+ * Computes the Householder vector of the given column in-place and returns alpha, such that
+ * \f$(I-2vv^T)x = -\alpha e_1\f$.
+ *
+ * @ingroup lapack_internal
+ */
+inline double
+__householder_vector(const VectorView<double> &v)
+{
+  double norm  = Blas::nrm2(v);
+  double alpha = v(0) < 0 ? norm : -norm;
+  v(0) += alpha; Blas::scal(1./Blas::nrm2(v), v);
+  return alpha;
+}
+
+
 
 /**
  * Performs a QR decomposition with the same interface as LAPACKs geqrf function. In contrast to
@@ -66,22 +80,21 @@ void geqrf(Matrix<double> &A, Vector<double> &tau) throw (ShapeError)
 
   size_t M = A.rows();
   size_t N = A.cols();
+  MatrixView<double> Aview(A);
 
   // Iterate over all columns of A
   for (size_t i=0; i<N; i++) {
     // Create view on sub-matrix of A as Asub = A[i:,i:]
     // and sub-vector vsub = A[i:,i] = Asub[:,0];
-    Matrix<double> Asub = A.sub(i,i, M-i,N-i);
-    Vector<double> vsub = Asub.col(0);
+    MatrixView<double> Asub = Aview.sub(i,i, M-i,N-i);
+    VectorView<double> vsub = Asub.col(0);
 
     // Now, calculate Householder projector H = 1-2*vsub*vsub^T
-    double alpha = vsub(0) < 0 ? std::abs(vsub) : -std::abs(vsub);
-    vsub(0) += alpha; vsub /= std::abs(vsub);
+    double alpha = __householder_vector(vsub);
 
     // Now, project all remaining columns of A[i:,i+1:], if some columns left
     for (size_t j=1; j<Asub.cols(); j++) {
-      Vector<double> tmp = Asub.col(j);
-      __prod_householder(vsub, tmp);
+      __prod_householder(vsub, Asub.col(j));
     }
     // Store v(0) in tau(i), alpha in A(i,i) and v[1:] in A[i+1:,i]
     tau(i) = vsub(0); vsub(0) = -alpha;
@@ -112,23 +125,22 @@ throw (ShapeError)
 
   size_t M = A.rows();
   size_t N = A.cols();
+  MatrixView<double> Aview(A);
 
   // Iterate over all columns of A
   for (size_t i=0; i<N; i++) {
     // Create view on sub-matrix of A as Asub = A[i:,i:]
     // and sub-vector vsub = A[i:,i] = Asub[:,0];
-    Matrix<double> Asub = A.sub(i,i, M-i,N-i);
-    Vector<double> vsub = Asub.col(0);
+    MatrixView<double> Asub = Aview.sub(i,i, M-i,N-i);
+    VectorView<double> vsub = Asub.col(0);
 
     // Now, calculate Householder projector H = 1-2*vsub*vsub^T
-    double alpha = vsub(0) < 0 ? std::abs(vsub) : -std::abs(vsub);
-    vsub(0) += alpha; vsub /= std::abs(vsub);
+    double alpha = __householder_vector(vsub);
 
     // Now, project all remaining columns of A[i:,i+1:], if some columns left
 #pragma omp parallel for
     for (size_t j=1; j<Asub.cols(); j++) {
-      Vector<double> tmp = Asub.col(j);
-      __prod_householder(vsub, tmp);
+      __prod_householder(vsub, Asub.col(j));
     }
     // Store v(0) in tau(i), alpha in A(i,i) and v[1:] in A[i+1:,i]
     tau(i) = vsub(0); vsub(0) = -alpha;
@@ -2,20 +2,44 @@
 #define __LINALG_LAPACK_ORMQR_HH__
 
 #include "geqrf.hh"
+#include "workspace.hh"
 
 
 namespace Linalg {
 namespace Lapack {
 
 
+/**
+ * Applies the i-th Householder projector stored in A and tau to b[i:], using v as workspace.
+ *
+ * @ingroup lapack_internal
+ */
+inline void
+__ormqr_apply(const MatrixView<double> &A, double tau_i, size_t i, const VectorView<double> &b,
+              const VectorView<double> &v)
+{
+  size_t M = A.rows();
+
+  // Assemble Householder projector in v:
+  VectorView<double> Ai = A.col(i);
+  v(0) = tau_i;
+  for (size_t k=i+1; k<M; k++) {
+    v(k-i) = Ai(k);
+  }
+
+  // Apply Householder
+  __prod_householder(v.sub(0, M-i), b.sub(i, M-i));
+}
+
+
 /**
  * This function performs the matrix-vector product \f$b' = op(Q)b\f$ if left=true and
  * \f$b'^T = b^Top(Q)\f$ if left=false, where \f$op(Q) = Q\f$ if trans=false and
  * \f$op(Q) = Q^T\f$ if trans=T; where Q is given as a product of elementary reflectors stored
  * in A and tau as generated by @c geqrf.
  */
-void ormqr(const Matrix<double> &A, const Vector<double> &tau, Vector<double> &b,
-           Vector<double> &v, bool trans=false, bool left=true) throw (ShapeError)
+void ormqr(const Matrix<double> &A, const Vector<double> &tau, const VectorView<double> &b,
+           const VectorView<double> &v, bool trans=false, bool left=true) throw (ShapeError)
 {
   LINALG_SHAPE_ASSERT(A.rows() == b.dim());
   LINALG_SHAPE_ASSERT(v.dim() >= A.rows());
@@ -23,26 +47,20 @@ void ormqr(const Matrix<double> &A, const Vector<double> &tau, Vector<double> &b
   size_t M = A.rows();
   size_t N = A.cols();
   size_t K = std::min(M-1, N);
+  MatrixView<double> Aview = __readonly_view(A);
+  VectorView<double> tauview = __readonly_view(tau);
 
   // Apply Householder projectors in reverse order
   if ( (left && !trans) || (!left && trans)) {
-    for (int i=K; i>=0; i--) {
-      // Assemble Householder projector in v:
-      v.sub(1,M-i-1).values() = A.col(i).sub(i+1, M-i-1); v(0) = tau(i);
-      // Apply Householder
-      Vector<double> b_sub = b.sub(i, M-i);
-      __prod_householder(v.sub(0, M-i), b_sub);
+    for (size_t i=K; i>0; i--) {
+      __ormqr_apply(Aview, tauview(i-1), i-1, b, v);
     }
   }
 
   // Apply Householder projectors in forward order
   else {
     for (size_t i=0; i<K; i++) {
-      // Assemble Householder projector in v:
-      v.sub(1,M-i-1).values() = A.col(i).sub(i+1, M-i-1); v(0) = tau(i);
-      // Apply Householder
-      Vector<double> b_sub(b.sub(i, M-i));
-      __prod_householder(v.sub(0, M-i), b_sub);
+      __ormqr_apply(Aview, tauview(i), i, b, v);
     }
   }
 }
@@ -54,25 +72,43 @@ void ormqr(const Matrix<double> &A, const Vector<double> &tau, Vector<double> &b
  * \f$op(Q) = Q^T\f$ if trans=T; where Q is given as a product of elementary reflectors stored
  * in A and tau as generated by @c geqrf.
  */
-void ormqr(const Matrix<double> &A, const Vector<double> &tau, Matrix<double> &B,
-           Vector<double> &v, bool trans=false, bool left=true) throw (ShapeError)
+void ormqr(const Matrix<double> &A, const Vector<double> &tau, const MatrixView<double> &B,
+           const VectorView<double> &v, bool trans=false, bool left=true) throw (ShapeError)
 {
   LINALG_SHAPE_ASSERT(A.rows() > 0);
   LINALG_SHAPE_ASSERT(A.rows() >= A.cols());
   LINALG_SHAPE_ASSERT(A.cols() <= tau.dim());
 
-  // For all columns in B:
-  for (size_t i=0; i<B.cols(); i++) {
-    Vector<double> Bcol;
-    if (left)
-      Bcol = B.col(i);
-    else
-      Bcol = B.row(i);
-    ormqr(A, tau, Bcol, v, trans, left);
+  // For all columns (left) or rows (right) in B:
+  size_t N = left ? B.cols() : B.rows();
+  for (size_t i=0; i<N; i++) {
+    ormqr(A, tau, left ? B.col(i) : B.row(i), v, trans, left);
   }
 }
 
 
+/**
+ * Same as above, but takes the temporary vector from the thread-local @c Workspace.
+ */
+void ormqr(const Matrix<double> &A, const Vector<double> &tau, const VectorView<double> &b,
+           bool trans=false, bool left=true) throw (ShapeError)
+{
+  Workspace::Frame frame;
+  ormqr(A, tau, b, frame.vector<double>(A.rows()), trans, left);
+}
+
+
+/**
+ * Same as above, but takes the temporary vector from the thread-local @c Workspace.
+ */
+void ormqr(const Matrix<double> &A, const Vector<double> &tau, const MatrixView<double> &B,
+           bool trans=false, bool left=true) throw (ShapeError)
+{
+  Workspace::Frame frame;
+  ormqr(A, tau, B, frame.vector<double>(A.rows()), trans, left);
+}
+
+
 }
 }
 #endif // __LINALG_LAPACK_ORMQR_HH__
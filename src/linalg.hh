@@ -31,6 +31,10 @@
  * @defgroup matrix Matrix and vector types
  */
 
+/**
+ * @defgroup io Binary storage of matrices and vectors
+ */
+
 
 
 #ifndef __LINALG_HH__
@@ -39,10 +43,12 @@
 #include "array.hh"
 #include "vector.hh"
 #include "matrix.hh"
+#include "view.hh"
 #include "trimatrix.hh"
 #include "symmatrix.hh"
 
 #include "workspace.hh"
+#include "io.hh"
 #include "exception.hh"
 
 #include "blas/blas.hh"
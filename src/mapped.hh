@@ -0,0 +1,333 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_MAPPED_HH__
+#define __LINALG_MAPPED_HH__
+
+#include "memory.hh"
+#include "matrix.hh"
+#include "vector.hh"
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace Linalg {
+
+/**
+ * A data manager, that backs an array with a memory-mapped file.
+ *
+ * The file is mapped shared, hence changes made to a read-write mapping are visible to other
+ * processes mapping the same file and are written back to the file by the OS or explicitly by
+ * @c sync. Writing to a read-only mapping results in a segmentation fault. The file is unmapped
+ * once the last reference to the data is dropped.
+ *
+ * The data is stored in the file in the native binary representation of @c Scalar, starting at
+ * the given byte offset. Use @c mapMatrix and @c mapVector to wrap the mapping into a matrix or
+ * vector.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+class MappedDataMngr : public DataMngr<Scalar>
+{
+public:
+  /** Access modes. */
+  typedef enum {
+    READ_ONLY,    ///< The mapping is read-only.
+    READ_WRITE    ///< The mapping is writable, changes are written back to the file.
+  } Mode;
+
+  /** Access pattern hints, see @c advise. */
+  typedef enum {
+    NORMAL,       ///< No special treatment (default).
+    SEQUENTIAL,   ///< Pages are accessed sequentially, enables aggressive read-ahead.
+    RANDOM,       ///< Pages are accessed randomly, disables read-ahead.
+    WILLNEED,     ///< Pages will be accessed soon, starts reading them in the background.
+    DONTNEED,     ///< Pages will not be accessed soon, they may be dropped from the page cache.
+    HUGEPAGES     ///< Back the mapping with transparent huge pages where supported.
+  } Advice;
+
+
+protected:
+  /** The page-aligned base address of the mapping. */
+  void *_base;
+  /** The length of the mapping in bytes. */
+  size_t _length;
+  /** The number of elements. */
+  size_t _size;
+  /** The access mode. */
+  Mode _mode;
+
+
+protected:
+  /**
+   * Hidden constructor, use @c open or @c create.
+   */
+  MappedDataMngr(void *base, size_t length, Scalar *data, size_t size, Mode mode)
+    : DataMngr<Scalar>(data, false), _base(base), _length(length), _size(size), _mode(mode)
+  {
+    // Pass...
+  }
+
+
+public:
+  /**
+   * Unmaps the file.
+   */
+  virtual ~MappedDataMngr() {
+    munmap(_base, _length);
+  }
+
+  /**
+   * Maps @c size elements of the given file starting at byte @c offset. If @c whole is true,
+   * @c size is ignored and the remainder of the file is mapped. Empty mappings are not
+   * possible, i.e. @c size (or the remainder) must not be 0.
+   *
+   * @throws IOError If the file can not be opened or mapped or is too small.
+   */
+  static MappedDataMngr<Scalar> *
+  open(const std::string &filename, Mode mode=READ_ONLY, size_t offset=0, size_t size=0,
+       bool whole=false)
+  throw (IOError)
+  {
+    int fd = ::open(filename.c_str(), (READ_ONLY == mode) ? O_RDONLY : O_RDWR);
+    if (0 > fd) {
+      IOError err;
+      err << "Can not open file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+
+    struct stat st;
+    if (0 != fstat(fd, &st)) {
+      ::close(fd);
+      IOError err;
+      err << "Can not stat file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+
+    size_t file_size = st.st_size;
+    if (whole) {
+      size = (offset < file_size) ? (file_size - offset)/sizeof(Scalar) : 0;
+    }
+
+    if ((0 == size) || (offset + size*sizeof(Scalar) > file_size)) {
+      ::close(fd);
+      IOError err;
+      err << "Can not map " << size << " elements at offset " << offset << " of file "
+          << filename << " of size " << file_size << ".";
+      throw err;
+    }
+
+    return map(fd, filename, mode, offset, size);
+  }
+
+  /**
+   * Creates (or truncates) the given file, such that it holds @c size elements at byte
+   * @c offset, and maps it read-write. The elements are initialized with zeros.
+   *
+   * @throws IOError If the file can not be created or mapped.
+   */
+  static MappedDataMngr<Scalar> *
+  create(const std::string &filename, size_t size, size_t offset=0)
+  throw (IOError)
+  {
+    int fd = ::open(filename.c_str(), O_RDWR|O_CREAT|O_TRUNC, 0644);
+    if (0 > fd) {
+      IOError err;
+      err << "Can not create file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+
+    if ((0 == size) || (0 != ftruncate(fd, offset + size*sizeof(Scalar)))) {
+      ::close(fd);
+      IOError err;
+      err << "Can not resize file " << filename << " to " << size << " elements.";
+      throw err;
+    }
+
+    return map(fd, filename, READ_WRITE, offset, size);
+  }
+
+  /**
+   * Gives the OS a hint about the access pattern. Returns false if the hint was rejected (e.g.
+   * huge pages are not supported for the file system), the mapping is unaffected in this case.
+   */
+  bool advise(Advice advice)
+  {
+    int flag = MADV_NORMAL;
+    switch (advice) {
+    case NORMAL:     flag = MADV_NORMAL; break;
+    case SEQUENTIAL: flag = MADV_SEQUENTIAL; break;
+    case RANDOM:     flag = MADV_RANDOM; break;
+    case WILLNEED:   flag = MADV_WILLNEED; break;
+    case DONTNEED:   flag = MADV_DONTNEED; break;
+    case HUGEPAGES:
+#ifdef MADV_HUGEPAGE
+      flag = MADV_HUGEPAGE; break;
+#else
+      return false;
+#endif
+    }
+
+    return 0 == madvise(_base, _length, flag);
+  }
+
+  /**
+   * Writes changes back to the file. If @c async is true, the write-back is only scheduled.
+   * Does nothing for read-only mappings.
+   *
+   * @throws IOError If the data can not be written.
+   */
+  void sync(bool async=false) throw (IOError)
+  {
+    if (READ_ONLY == _mode) {
+      return;
+    }
+
+    if (0 != msync(_base, _length, async ? MS_ASYNC : MS_SYNC)) {
+      IOError err;
+      err << "Can not sync mapped file: " << strerror(errno);
+      throw err;
+    }
+  }
+
+  /** Returns the number of mapped elements. */
+  inline size_t size() const { return _size; }
+
+  /** Returns the access mode. */
+  inline Mode mode() const { return _mode; }
+
+  /** Returns true if the mapping is writable. */
+  virtual bool isWritable() const { return READ_WRITE == _mode; }
+
+
+protected:
+  /**
+   * Maps the given file descriptor and closes it.
+   */
+  static MappedDataMngr<Scalar> *
+  map(int fd, const std::string &filename, Mode mode, size_t offset, size_t size)
+  throw (IOError)
+  {
+    // The offset of a mapping must be a multiple of the page size:
+    size_t page   = sysconf(_SC_PAGESIZE);
+    size_t base   = (offset/page)*page;
+    size_t length = offset - base + size*sizeof(Scalar);
+
+    int prot = PROT_READ | ((READ_WRITE == mode) ? PROT_WRITE : 0);
+    void *ptr = mmap(0, length, prot, MAP_SHARED, fd, base);
+    ::close(fd);
+
+    if (MAP_FAILED == ptr) {
+      IOError err;
+      err << "Can not map file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+
+    Scalar *data = reinterpret_cast<Scalar *>(reinterpret_cast<char *>(ptr) + (offset-base));
+    return new MappedDataMngr<Scalar>(ptr, length, data, size, mode);
+  }
+};
+
+
+/**
+ * Returns the @c MappedDataMngr of the given array or 0 if the array is not backed by a mapped
+ * file.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline MappedDataMngr<Scalar> *
+mapped(const DataPtr<Scalar> &array)
+{
+  return dynamic_cast<MappedDataMngr<Scalar> *>(array.dataManager());
+}
+
+
+/**
+ * Wraps the given mapping into a matrix with @c rows x @c cols elements.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline Matrix<Scalar>
+mapMatrix(MappedDataMngr<Scalar> *mngr, size_t rows, size_t cols, bool rowmajor=true)
+throw (ShapeError)
+{
+  DataPtr<Scalar> data(mngr);
+  LINALG_SHAPE_ASSERT(rows*cols <= mngr->size());
+
+  Shape dims(2); dims[0] = rows; dims[1] = cols;
+  Shape strd(2);
+  if (rowmajor) { strd[0] = cols; strd[1] = 1; }
+  else { strd[0] = 1; strd[1] = rows; }
+  return Matrix<Scalar>(Array<Scalar>(data, 0, dims, strd));
+}
+
+
+/**
+ * Maps a @c rows x @c cols matrix stored at byte @c offset of the given file.
+ *
+ * @throws IOError If the file can not be mapped.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline Matrix<Scalar>
+mapMatrix(const std::string &filename, size_t rows, size_t cols, bool rowmajor=true,
+          typename MappedDataMngr<Scalar>::Mode mode=MappedDataMngr<Scalar>::READ_ONLY,
+          size_t offset=0)
+throw (IOError, ShapeError)
+{
+  return mapMatrix(MappedDataMngr<Scalar>::open(filename, mode, offset, rows*cols),
+                   rows, cols, rowmajor);
+}
+
+
+/**
+ * Wraps the given mapping into a vector.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline Vector<Scalar>
+mapVector(MappedDataMngr<Scalar> *mngr)
+{
+  DataPtr<Scalar> data(mngr);
+  return Vector<Scalar>(Array<Scalar>(data, 0, Shape(1, mngr->size()), Shape(1, 1)));
+}
+
+
+/**
+ * Maps a vector of dimension @c dim stored at byte @c offset of the given file. If @c dim is
+ * 0, the remainder of the file is mapped.
+ *
+ * @throws IOError If the file can not be mapped.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline Vector<Scalar>
+mapVector(const std::string &filename, size_t dim=0,
+          typename MappedDataMngr<Scalar>::Mode mode=MappedDataMngr<Scalar>::READ_ONLY,
+          size_t offset=0)
+throw (IOError)
+{
+  return mapVector(MappedDataMngr<Scalar>::open(filename, mode, offset, dim, 0 == dim));
+}
+
+
+}
+
+#endif // __LINALG_MAPPED_HH__
@@ -11,6 +11,8 @@
 
 #include "array.hh"
 #include "vector.hh"
+#include "numa.hh"
+#include "random.hh"
 #include "blas/utils.hh"
 #include <iostream>
 
@@ -43,31 +45,42 @@ protected:
 public:
   Matrix(const DataPtr<Scalar> &data, size_t offset, size_t rows, size_t cols,
          size_t row_stride, size_t col_stride)
-    : Array<Scalar>(data, offset, std::vector<size_t>(1, rows*cols), std::vector<size_t>(1, 1))
+    : Array<Scalar>(data, offset, Shape(2), Shape(2))
   {
-    this->_shape.resize(2); this->_shape[0] = rows; this->_shape[1] = cols;
-    this->_strides.resize(2); this->_strides[0] = row_stride; this->_strides[1] = col_stride;
+    this->_shape[0] = rows; this->_shape[1] = cols;
+    this->_strides[0] = row_stride; this->_strides[1] = col_stride;
   }
 
 
   /**
    * Constructor for an empty matrix.
+   *
+   * The memory is aligned to @c LINALG_ALIGNMENT. If @c padded is true, the leading dimension is
+   * rounded up (see @c __padded_dimension), such that every row (row-major) or column
+   * (column-major) starts at a cache-line boundary.
    */
-  Matrix(size_t rows, size_t cols, bool rowmajor=true)
+  Matrix(size_t rows, size_t cols, bool rowmajor=true, bool padded=false)
     : Array<Scalar>()
   {
+    size_t ld = rowmajor ? cols : rows;
+    if (padded) {
+      ld = __padded_dimension<Scalar>(ld);
+    }
+
     // Allocate some data and assign it to this:
-    DataPtr<Scalar>::operator =(DataPtr<Scalar>(new DataMngr<Scalar>(rows*cols)));
+    DataPtr<Scalar>::operator =(
+          DataPtr<Scalar>(DataMngr<Scalar>::allocate(ld * (rowmajor ? rows : cols))));
+    NUMA::place(this->_mngr->ptr(), ld * (rowmajor ? rows : cols) * sizeof(Scalar));
 
     this->_offset = 0;
     this->_shape.resize(2); this->_shape[0] = rows; this->_shape[1] = cols;
     this->_strides.resize(2);
     if (rowmajor) {
-      this->_strides[0] = cols;
+      this->_strides[0] = ld;
       this->_strides[1] = 1;
     } else {
       this->_strides[0] = 1;
-      this->_strides[1] = rows;
+      this->_strides[1] = ld;
     }
   }
 
@@ -91,6 +104,15 @@ public:
     // Pass...
   }
 
+  /**
+   * Move constructor, leaves @c other as an empty matrix.
+   */
+  Matrix(Matrix<Scalar> &&other) noexcept
+    : Array<Scalar>(std::move(other))
+  {
+    // Pass...
+  }
+
   /**
    * Copy constructor with ownership transfer.
    */
@@ -100,6 +122,44 @@ public:
     LINALG_SHAPE_ASSERT(2 == other.ndim());
   }
 
+  /**
+   * Allocates a new matrix and evaluates the given element-wise expression into it.
+   */
+  template <class Expr>
+  Matrix(const ArrayExpr<Expr> &expr)
+    : Array<Scalar>(expr)
+  {
+    LINALG_SHAPE_ASSERT(2 == this->ndim());
+  }
+
+  /**
+   * Move constructor from a 2D array.
+   */
+  Matrix(Array<Scalar> &&other)
+    : Array<Scalar>(std::move(other))
+  {
+    LINALG_SHAPE_ASSERT(2 == this->ndim());
+  }
+
+
+  /**
+   * Assignment operator (view assignment), see @c Array::operator=.
+   */
+  inline Matrix<Scalar> &operator= (const Matrix<Scalar> &other)
+  {
+    Array<Scalar>::operator =(other);
+    return *this;
+  }
+
+  /**
+   * Move assignment, leaves @c other as an empty matrix.
+   */
+  inline Matrix<Scalar> &operator= (Matrix<Scalar> &&other) noexcept
+  {
+    Array<Scalar>::operator =(std::move(other));
+    return *this;
+  }
+
 
   /**
    * Explicit copy of the matrix.
@@ -111,17 +171,59 @@ public:
     return Matrix<Scalar>(Array<Scalar>::copy(rowmajor));
   }
 
-  void swap(Matrix<Scalar> &other)
+  /**
+   * Exchanges the data and shape of this matrix and @c other.
+   */
+  inline void swap(Matrix<Scalar> &other) noexcept
   {
-    Matrix<Scalar> tmp = other;
-    other = *this;
-    Array<Scalar>::operator =(tmp);
+    Array<Scalar>::swap(other);
   }
 
   Matrix<Scalar> t() const {
     return Array<Scalar>::t();
   }
 
+  /**
+   * Transposes the matrix in-place, i.e. materializes @c t() without allocating a new matrix:
+   * Afterwards the matrix has @c cols() rows and @c rows() columns and the same storage order.
+   *
+   * Square matrices (also strided views) are transposed by swapping tiles across the diagonal,
+   * rectangular matrices must be dense and are transposed by following the cycles of the
+   * permutation (see @c __transpose_inplace). Note that the data is rearranged, hence other
+   * references to the data (e.g. views) see the transposed values.
+   *
+   * @throws ShapeError If the matrix is rectangular and not dense.
+   */
+  inline Matrix<Scalar> &transpose()
+  {
+    size_t m = rows(), n = cols();
+    Scalar *ptr = this->_data + this->_offset;
+
+    if (m == n) {
+      __transpose_square(ptr, n, this->_strides[0], this->_strides[1]);
+      return *this;
+    }
+
+    bool rowmajor = this->isRowMajor();
+    bool dense = rowmajor ? ((1 == m) || (n == this->_strides[0]))
+                          : ((1 == this->_strides[0]) && ((1 == n) || (m == this->_strides[1])));
+    if (! dense) {
+      ShapeError err;
+      err << "Can not transpose a non-dense " << m << "x" << n << " matrix in-place.";
+      throw err;
+    }
+
+    if (rowmajor) {
+      __transpose_inplace(ptr, m, n);
+      this->_strides[0] = m; this->_strides[1] = 1;
+    } else {
+      __transpose_inplace(ptr, n, m);
+      this->_strides[0] = 1; this->_strides[1] = n;
+    }
+    this->_shape[0] = n; this->_shape[1] = m;
+    return *this;
+  }
+
 
   /**
    * Returns the number of rows of the matrix.
@@ -216,8 +318,6 @@ public:
       throw err;
     }
 
-    std::vector<size_t> shape(2);
-    shape[0] = nrow; shape[1] = ncol;
     return Matrix<Scalar>(*this, this->_getIndex(i,j), nrow, ncol, this->strides()[0], this->strides()[1]);
   }
 
@@ -230,8 +330,8 @@ public:
                                  size_t rows, size_t cols, size_t rstride, size_t cstride,
                                  size_t offset=0)
   {
-    std::vector<size_t> dims(2); dims[0]=rows; dims[1]=cols;
-    std::vector<size_t> strd(2); strd[0]=rstride; strd[1]=cstride;
+    Shape dims(2); dims[0]=rows; dims[1]=cols;
+    Shape strd(2); strd[0]=rstride; strd[1]=cstride;
     Matrix<Scalar> ret(
           Array<Scalar>(
             DataPtr<Scalar>(new DataMngr<Scalar>(data, false)),
@@ -248,8 +348,8 @@ public:
   fromUnownedData(Scalar *data, size_t rows, size_t cols, size_t rstride, size_t cstride,
                   size_t offset=0)
   {
-    std::vector<size_t> dims(2); dims[0]=rows; dims[1]=cols;
-    std::vector<size_t> strd(2); strd[0]=rstride; strd[1]=cstride;
+    Shape dims(2); dims[0]=rows; dims[1]=cols;
+    Shape strd(2); strd[0]=rstride; strd[1]=cstride;
     Matrix<Scalar> ret(Array<Scalar>(data, offset, dims, strd, true));
     return ret;
   }
@@ -265,6 +365,17 @@ public:
   }
 
 
+  /**
+   * Constructs a matrix with uninitilized values and a padded leading dimension, such that every
+   * row (row-major) or column (column-major) is aligned to @c LINALG_ALIGNMENT.
+   */
+  static Matrix<Scalar> padded(size_t rows, size_t cols, bool rowmajor=true)
+  {
+    Matrix<Scalar> ret(rows, cols, rowmajor, true);
+    return ret;
+  }
+
+
   /**
    * Returns a matrix initialized with all values = 0.
    */
@@ -272,13 +383,8 @@ public:
   {
     Matrix<Scalar> m(rows, cols);
 
-    for (size_t i=0; i<rows; i++)
-    {
-      for (size_t j=0; j<cols; j++)
-      {
-        m(i,j) = 0;
-      }
-    }
+    // First touch according to the NUMA policy:
+    __first_touch(m.ptr(), rows, cols, m.strides(0), Scalar(0));
 
     return m;
   }
@@ -310,20 +416,51 @@ public:
 
 
   /**
-   * Constructs a new matrix initialized with [0,1] uniform distributed random-numbers.
+   * Constructs a new matrix initialized with [0,1) uniform distributed random numbers of the
+   * next stream of the global seed (see @c Random).
    */
   static Matrix<Scalar> rand(size_t rows, size_t cols)
   {
-    Matrix<Scalar> m(rows, cols);
+    return Matrix<Scalar>::random(rows, cols, Random::next(), false);
+  }
 
-    for (size_t i=0; i<rows; i++)
-    {
-      for (size_t j=0; j<cols; j++)
-      {
-        m(i,j) = Scalar(std::rand())/RAND_MAX;
-      }
-    }
+  /**
+   * Constructs a new matrix initialized with [0,1) uniform distributed random numbers of the
+   * given seed. The values are reproducible, independent of the number of threads.
+   */
+  static Matrix<Scalar> rand(size_t rows, size_t cols, uint64_t seed)
+  {
+    return Matrix<Scalar>::random(rows, cols, Philox(seed), false);
+  }
+
+  /**
+   * Constructs a new matrix initialized with standard normal distributed random numbers of the
+   * next stream of the global seed (see @c Random).
+   */
+  static Matrix<Scalar> randn(size_t rows, size_t cols)
+  {
+    return Matrix<Scalar>::random(rows, cols, Random::next(), true);
+  }
+
+  /**
+   * Constructs a new matrix initialized with standard normal distributed random numbers of the
+   * given seed.
+   */
+  static Matrix<Scalar> randn(size_t rows, size_t cols, uint64_t seed)
+  {
+    return Matrix<Scalar>::random(rows, cols, Philox(seed), true);
+  }
+
+  /**
+   * Constructs a new matrix initialized with uniform or normal distributed random numbers of
+   * the given generator, see @c __random_fill.
+   */
+  static Matrix<Scalar> random(size_t rows, size_t cols, const Philox &gen, bool normal)
+  {
+    Matrix<Scalar> m(rows, cols);
 
+    // A parallel fill first-touches the pages in contiguous row ranges (see NUMA):
+    __random_fill(m.ptr(), rows, cols, m.strides(0), m.strides(1), gen, normal);
     return m;
   }
 };
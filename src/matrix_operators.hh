@@ -2,8 +2,10 @@
 #define __LINALG_MATRIX_OPERATORS_HH__
 
 #include "matrix.hh"
+#include "expression.hh"
 #include "blas/gemm.hh"
 #include "blas/gemv.hh"
+#include "blas/scal.hh"
 
 
 namespace Linalg {
@@ -21,9 +23,10 @@ inline Matrix<Scalar>
 operator* (const Matrix<Scalar> &lhs, const Matrix<Scalar> &rhs) throw (ShapeError)
 {
   // Allocate matrix for result:
+  LINALG_MEMSTATS_TAG("operator*(Matrix,Matrix)");
   Matrix<Scalar> result(lhs.rows(), rhs.cols());
   // Use Blas::gemm() to compute product
-  Blas::gemm(Scalar(1), lhs, rhs, Scalar(0), result);
+  Blas::gemm(Scalar(1), __readonly_view(lhs), __readonly_view(rhs), Scalar(0), result);
   // Pass ownership of result-matrix to caller...
   return result;
 }
@@ -43,71 +46,51 @@ inline Vector<Scalar>
 operator* (const Matrix<Scalar> &lhs, const Vector<Scalar> &rhs) throw (ShapeError)
 {
   // Allocate vector for result:
+  LINALG_MEMSTATS_TAG("operator*(Matrix,Vector)");
   Vector<Scalar> result(rhs.dim());
   // Use Blas::gemv() to compute product
-  Blas::gemv(Scalar(1), lhs, rhs, Scalar(0), result);
+  Blas::gemv(Scalar(1), __readonly_view(lhs), __readonly_view(rhs), Scalar(0), result);
   // Pass ownership of result vector to caller...
   return result;
 }
 
 
 /**
- * Implements the common matrix sum.
- *
- * @note This operator is quiet inefficient, as a matrix is allocated to hold the itermediate result
- *       of the operation. Whenever possible, use the in-place operator +=.
+ * Matrix product with an element-wise expression (see @c ArrayExpr) as right operand. The
+ * expression is evaluated into a temporary matrix first, i.e. it must be 2-dimensional. To
+ * multiply with a vector expression, evaluate it explicitly (e.g. @c A*Vector<double>(x+y)).
  *
  * @ingroup operators
  */
-inline Matrix<double>
-operator+ (const Matrix<double> &lhs, const Matrix<double> &rhs)
+template <class Scalar, class Expr>
+inline Matrix<Scalar>
+operator* (const Matrix<Scalar> &lhs, const ArrayExpr<Expr> &rhs) throw (ShapeError)
 {
-  // Check shape:
-  LINALG_SHAPE_ASSERT(lhs.rows() == rhs.rows());
-  LINALG_SHAPE_ASSERT(rhs.cols() == rhs.cols());
-
-  // Allocate result matrix.
-  Matrix<double> result(lhs.rows(), lhs.cols());
-
-  // Perform sum:
-  for (size_t i=0; i<lhs.rows(); i++) {
-    for (size_t j=0; j<lhs.cols(); j++) {
-      result(i,j) = lhs(i,j) + rhs(i,j);
-    }
-  }
-
-  // Pass ownership of result to caller:
-  return result;
+  return lhs * Matrix<Scalar>(rhs);
 }
 
-
-/**
- * Implements the common matrix difference.
- *
- * @note This operator is quiet inefficient, as a matrix is allocated to hold the itermediate result
- *       of the operation. Whenever possible, use the in-place operator -=.
- *
- * @ingroup operators
- */
-inline Matrix<double>
-operator- (const Matrix<double> &lhs, const Matrix<double> &rhs)
+/** Matrix product with an element-wise expression as left operand. */
+template <class Expr, class Scalar>
+inline Matrix<Scalar>
+operator* (const ArrayExpr<Expr> &lhs, const Matrix<Scalar> &rhs) throw (ShapeError)
 {
-  // Check shape:
-  LINALG_SHAPE_ASSERT(lhs.rows() == rhs.rows());
-  LINALG_SHAPE_ASSERT(rhs.cols() == rhs.cols());
-
-  // Allocate result matrix.
-  Matrix<double> result(lhs.rows(), lhs.cols());
+  return Matrix<Scalar>(lhs) * rhs;
+}
 
-  // Perform sum:
-  for (size_t i=0; i<lhs.rows(); i++) {
-    for (size_t j=0; j<lhs.cols(); j++) {
-      result(i,j) = lhs(i,j) - rhs(i,j);
-    }
-  }
+/** Matrix product of two element-wise expressions. */
+template <class L, class R>
+inline Matrix<typename L::value_type>
+operator* (const ArrayExpr<L> &lhs, const ArrayExpr<R> &rhs) throw (ShapeError)
+{
+  return Matrix<typename L::value_type>(lhs) * Matrix<typename L::value_type>(rhs);
+}
 
-  // Pass ownership of result to caller:
-  return result;
+/** Matrix-vector product with an element-wise matrix expression as left operand. */
+template <class Expr, class Scalar>
+inline Vector<Scalar>
+operator* (const ArrayExpr<Expr> &lhs, const Vector<Scalar> &rhs) throw (ShapeError)
+{
+  return Matrix<Scalar>(lhs) * rhs;
 }
 
 
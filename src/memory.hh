@@ -11,40 +11,166 @@
 #define __LINALG_MEMORY_HH__
 
 #include "exception.hh"
+#include "pool.hh"
+#include "memstats.hh"
 #include <memory>
+#include <atomic>
+#include <utility>
+#include <new>
+#include <cstdlib>
 
 
 namespace Linalg {
 
+/**
+ * Returns the smallest leading dimension >= @c n, such that consecutive rows (or columns) of a
+ * matrix start at a @c LINALG_ALIGNMENT boundary. If the element size does not divide the
+ * alignment, @c n is returned unchanged.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline size_t __padded_dimension(size_t n)
+{
+  if (0 != (LINALG_ALIGNMENT % sizeof(Scalar))) {
+    return n;
+  }
+
+  size_t n_elm = LINALG_ALIGNMENT/sizeof(Scalar);
+  return ((n + n_elm - 1)/n_elm)*n_elm;
+}
+
+
+
 /**
  * Template prototype for manager classes.
+ *
+ * A manager either holds a reference to some external data (owned or not) or allocates the data
+ * itself (see @c DataMngr::allocate). In the latter case, the manager and the data share a single
+ * block of memory taken from the @c MemoryPool, and the data is aligned to @c LINALG_ALIGNMENT.
+ *
+ * The manager also holds the (atomic) reference counter used by @c DataPtr. Once the last
+ * reference is dropped, @c destroy is called.
  */
 template <class Scalar>
 class DataMngr
 {
 private:
+  /** Holds the data pointer. */
   Scalar *_data;
+
+  /** If true, the data will be freed by the manager. */
   bool _owned;
 
+  /** If true, the manager and the data were allocated by @c allocate as a single block. */
+  bool _allocated;
+
+  /** Holds the number of elements, if the data was allocated by the manager itself. */
+  size_t _size;
+
+  /** Holds the number of @c DataPtr instances referencing this manager. */
+  std::atomic<size_t> _refcount;
+
+  /** Holds the @c MemStats tag of the allocation. */
+  const char *_tag;
+
+
+private:
+  /**
+   * Hidden constructor, used by @c allocate.
+   */
+  DataMngr(Scalar *data, size_t size)
+    : _data(data), _owned(true), _allocated(true), _size(size), _refcount(0), _tag(0)
+  {
+    for (size_t i=0; i<_size; i++) {
+      new (_data+i) Scalar;
+    }
+  }
+
+  /**
+   * Returns the size of the header (in bytes) preceding the data in a single-block allocation.
+   */
+  static inline size_t headerSize() {
+    return ((sizeof(DataMngr<Scalar>) + LINALG_ALIGNMENT - 1)/LINALG_ALIGNMENT)*LINALG_ALIGNMENT;
+  }
+
+
 public:
+  /**
+   * Manages the given data, if @c owned is true, the data will be freed using @c delete[].
+   */
   DataMngr(Scalar *data, bool owned)
-    : _data(data), _owned(owned)
+    : _data(data), _owned(owned), _allocated(false), _size(0), _refcount(0), _tag(0)
   {
     // Pass...
   }
 
-  explicit DataMngr(size_t size)
+  virtual ~DataMngr() {
+    if (! _owned) {
+      return;
+    }
+
+    if (_allocated) {
+      // Data is part of the block, just destroy the elements:
+      for (size_t i=0; i<_size; i++) {
+        _data[i].~Scalar();
+      }
+    } else {
+      delete[] _data;
+    }
+  }
+
+  /**
+   * Allocates a manager together with (uninitialized) memory for @c size elements as a single
+   * block from the @c MemoryPool. The data is aligned to @c LINALG_ALIGNMENT.
+   */
+  static DataMngr<Scalar> *allocate(size_t size)
   {
-    _data = new Scalar[size];
-    _owned = true;
+    char *block = reinterpret_cast<char *>(
+          MemoryPool::alloc(headerSize() + size*sizeof(Scalar)));
+    DataMngr<Scalar> *mngr =
+        new (block) DataMngr<Scalar>(reinterpret_cast<Scalar *>(block+headerSize()), size);
+    mngr->_tag = MemStats::allocated(size*sizeof(Scalar), "Array");
+    return mngr;
   }
 
-  virtual ~DataMngr() {
-    if (_owned) {
-      delete _data;
+  /**
+   * Frees the manager (and the data if owned). Called by @c DataPtr, once the last reference is
+   * dropped.
+   */
+  virtual void destroy()
+  {
+    if (_allocated) {
+      size_t bytes = headerSize() + _size*sizeof(Scalar);
+      MemStats::released(_size*sizeof(Scalar), _tag);
+      this->~DataMngr();
+      MemoryPool::free(this, bytes);
+    } else {
+      delete this;
     }
   }
 
+  /**
+   * Increments the reference counter.
+   */
+  inline void ref() {
+    _refcount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Decrements the reference counter, returns true if the last reference was dropped.
+   */
+  inline bool unref() {
+    return 1 == _refcount.fetch_sub(1, std::memory_order_acq_rel);
+  }
+
+  /**
+   * Returns the current number of references.
+   */
+  inline size_t refCount() const {
+    return _refcount.load(std::memory_order_relaxed);
+  }
+
   Scalar *ptr() const {
     return _data;
   }
@@ -52,12 +178,22 @@ public:
   bool ownsData() const {
     return _owned;
   }
+
+  /**
+   * Returns true if the data may be written (e.g. false for read-only mappings).
+   */
+  virtual bool isWritable() const {
+    return true;
+  }
 };
 
 
 
 /**
  * A simple base class holding an owned or unowned reference to some data.
+ *
+ * The reference counter is held by the @c DataMngr and updated atomically, hence views to the
+ * same data can be created and destroyed concurrently by several threads.
  */
 template <class Scalar>
 class DataPtr
@@ -73,10 +209,19 @@ protected:
    */
   Scalar *_data;
 
+
+protected:
   /**
-   * Holds a reference to the reference counter.
+   * Drops the reference to the data manager.
    */
-  size_t *_refcount;
+  inline void _release()
+  {
+    if ((0 != _mngr) && _mngr->unref()) {
+      _mngr->destroy();
+    }
+    _mngr = 0;
+    _data = 0;
+  }
 
 
 public:
@@ -84,7 +229,7 @@ public:
    * Empty constructor.
    */
   DataPtr()
-    : _mngr(0), _data(0), _refcount(0)
+    : _mngr(0), _data(0)
   {
     // Pass...
   }
@@ -95,17 +240,27 @@ public:
   DataPtr(DataMngr<Scalar> *mngr)
     : _mngr(mngr), _data(mngr->ptr())
   {
-    _refcount = new size_t(1);
+    _mngr->ref();
   }
 
   /**
    * Copy constructor.
    */
   DataPtr(const DataPtr<Scalar> &other)
-    : _mngr(other._mngr), _data(other._data), _refcount(other._refcount)
+    : _mngr(other._mngr), _data(other._data)
   {
-    if (0 != _refcount)
-      (*_refcount)++;
+    if (0 != _mngr)
+      _mngr->ref();
+  }
+
+  /**
+   * Move constructor, takes the reference of @c other leaving it empty.
+   */
+  DataPtr(DataPtr<Scalar> &&other) noexcept
+    : _mngr(other._mngr), _data(other._data)
+  {
+    other._mngr = 0;
+    other._data = 0;
   }
 
   /**
@@ -113,16 +268,7 @@ public:
    */
   ~DataPtr()
   {
-    if (0 != _refcount) {
-      (*_refcount)--;
-      if (0 == *_refcount) {
-        delete _mngr;
-        delete _refcount;
-        _mngr = 0;
-        _refcount = 0;
-        _data = 0;
-      }
-    }
+    _release();
   }
 
 
@@ -131,25 +277,60 @@ public:
    */
   DataPtr<Scalar> &operator =(const DataPtr<Scalar> &other)
   {
-    if (0 != _refcount) {
-      (*_refcount)--;
-      if (0 == *_refcount) {
-        delete _mngr;
-        delete _refcount;
-        _mngr = 0;
-        _refcount = 0;
-        _data = 0;
-      }
-    }
+    // Get reference first, allows for self-assignment:
+    if (0 != other._mngr)
+      other._mngr->ref();
+    DataMngr<Scalar> *mngr = other._mngr;
+    Scalar *data = other._data;
 
-    _mngr = other._mngr;
-    _data = other._data;
-    _refcount = other._refcount;
-    if (0 != _refcount)
-      (*_refcount)++;
+    _release();
+    _mngr = mngr;
+    _data = data;
 
     return *this;
   }
+
+
+  /**
+   * Move assignment, takes the reference of @c other leaving it empty.
+   */
+  DataPtr<Scalar> &operator =(DataPtr<Scalar> &&other) noexcept
+  {
+    if (this != &other) {
+      _release();
+      _mngr = other._mngr; other._mngr = 0;
+      _data = other._data; other._data = 0;
+    }
+
+    return *this;
+  }
+
+
+  /**
+   * Exchanges the references of this and @c other.
+   */
+  inline void swap(DataPtr<Scalar> &other) noexcept
+  {
+    std::swap(_mngr, other._mngr);
+    std::swap(_data, other._data);
+  }
+
+
+  /**
+   * Returns the number of references to the data, 0 if there is no data.
+   */
+  inline size_t refCount() const
+  {
+    return (0 == _mngr) ? 0 : _mngr->refCount();
+  }
+
+  /**
+   * Returns the manager of the data, or 0 if there is no data.
+   */
+  inline DataMngr<Scalar> *dataManager() const
+  {
+    return _mngr;
+  }
 };
 
 }
@@ -0,0 +1,393 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_MEMSTATS_HH__
+#define __LINALG_MEMSTATS_HH__
+
+#include <cstddef>
+#include <iostream>
+
+#ifdef LINALG_MEMSTATS
+#include <map>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <algorithm>
+#endif
+
+
+/**
+ * Specifies the number of largest allocations kept by @c Linalg::MemStats.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_MEMSTATS_TOP
+#define LINALG_MEMSTATS_TOP 10
+#endif
+
+
+/**
+ * Attributes all allocations of the calling thread until the end of the enclosing block to the
+ * given tag (a string literal). Expands to nothing unless @c LINALG_MEMSTATS is defined.
+ *
+ * @ingroup matrix
+ */
+#ifdef LINALG_MEMSTATS
+#define LINALG_MEMSTATS_TAG(name) Linalg::MemStats::Tag __linalg_memstats_tag(name)
+#else
+#define LINALG_MEMSTATS_TAG(name)
+#endif
+
+
+namespace Linalg {
+
+/**
+ * Counters of a single tag, see @c MemStats.
+ *
+ * @ingroup matrix
+ */
+struct MemStatsEntry
+{
+  /** The tag. */
+  const char *tag;
+  /** Number of allocations. */
+  size_t count;
+  /** Total number of bytes allocated. */
+  size_t bytes;
+  /** Number of bytes currently allocated. */
+  size_t live;
+  /** Maximum of @c live. */
+  size_t peak;
+};
+
+
+/**
+ * Accounting of the memory allocated by the library.
+ *
+ * If @c LINALG_MEMSTATS is defined, all allocations of array memory (@c DataMngr::allocate),
+ * of @c Workspace chunks and of @c Workspace::ensure are recorded. For each allocation, the
+ * number of bytes is attributed to a tag, which is either the innermost active
+ * @c MemStats::Tag of the calling thread (see @c LINALG_MEMSTATS_TAG) or the kind of the
+ * allocation. The accounting tracks the live and peak bytes (in total and per tag), the
+ * allocation counts per tag and the @c LINALG_MEMSTATS_TOP largest allocations.
+ *
+ * Without @c LINALG_MEMSTATS, all methods are no-ops and return zeros, such that the
+ * instrumentation has no runtime costs.
+ *
+ * @code
+ * MemStats::Scope scope;
+ * {
+ *   LINALG_MEMSTATS_TAG("solver");
+ *   ... // compute
+ * }
+ * std::cerr << "Peak: " << scope.peak() << " bytes" << std::endl;
+ * MemStats::dump(std::cerr);
+ * @endcode
+ *
+ * @ingroup matrix
+ */
+class MemStats
+{
+public:
+  /**
+   * Attributes the allocations of the calling thread to the given tag while it exists. Tags
+   * can be nested, the innermost one is used. The name must outlive the accounting (i.e. use
+   * string literals).
+   */
+  class Tag
+  {
+  protected:
+    /** The previous tag. */
+    const char *_previous;
+
+  public:
+    /** Activates the tag. */
+    explicit Tag(const char *name)
+      : _previous(MemStats::currentTag())
+    {
+      MemStats::currentTag() = name;
+    }
+
+    /** Restores the previous tag. */
+    ~Tag() {
+      MemStats::currentTag() = _previous;
+    }
+  };
+
+  /**
+   * Measures the allocations within a region of code (of all threads). Scopes can be nested.
+   */
+  class Scope
+  {
+  protected:
+    /** The number of allocations at construction. */
+    size_t _count;
+    /** The total number of bytes allocated at construction. */
+    size_t _bytes;
+    /** The live bytes at construction. */
+    size_t _live;
+    /** The peak of the enclosing scope at construction. */
+    size_t _outer_peak;
+
+  public:
+    /** Starts the measurement. */
+    Scope() {
+#ifdef LINALG_MEMSTATS
+      std::lock_guard<std::mutex> lock(MemStats::state().mutex);
+      State &s = MemStats::state();
+      _count = s.count; _bytes = s.bytes; _live = s.live;
+      _outer_peak = s.scope_peak; s.scope_peak = s.live;
+#else
+      _count = _bytes = _live = _outer_peak = 0;
+#endif
+    }
+
+    /** Ends the measurement. */
+    ~Scope() {
+#ifdef LINALG_MEMSTATS
+      std::lock_guard<std::mutex> lock(MemStats::state().mutex);
+      State &s = MemStats::state();
+      s.scope_peak = std::max(s.scope_peak, _outer_peak);
+#endif
+    }
+
+    /** Returns the number of allocations within the scope. */
+    size_t count() const {
+#ifdef LINALG_MEMSTATS
+      std::lock_guard<std::mutex> lock(MemStats::state().mutex);
+      return MemStats::state().count - _count;
+#else
+      return 0;
+#endif
+    }
+
+    /** Returns the number of bytes allocated within the scope. */
+    size_t bytes() const {
+#ifdef LINALG_MEMSTATS
+      std::lock_guard<std::mutex> lock(MemStats::state().mutex);
+      return MemStats::state().bytes - _bytes;
+#else
+      return 0;
+#endif
+    }
+
+    /** Returns the maximum number of live bytes within the scope above the level at its start. */
+    size_t peak() const {
+#ifdef LINALG_MEMSTATS
+      std::lock_guard<std::mutex> lock(MemStats::state().mutex);
+      size_t p = MemStats::state().scope_peak;
+      return (p > _live) ? (p - _live) : 0;
+#else
+      return 0;
+#endif
+    }
+  };
+
+
+public:
+  /** Returns true if the accounting is compiled in. */
+  static inline bool enabled() {
+#ifdef LINALG_MEMSTATS
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Records an allocation of @c bytes, attributed to the current tag or to @c kind. Returns the
+   * tag, that must be passed to @c released.
+   */
+  static inline const char *allocated(size_t bytes, const char *kind) {
+#ifdef LINALG_MEMSTATS
+    const char *tag = (0 != currentTag()) ? currentTag() : kind;
+    std::lock_guard<std::mutex> lock(state().mutex);
+    State &s = state();
+    s.count++; s.bytes += bytes; s.live += bytes;
+    s.peak = std::max(s.peak, s.live); s.scope_peak = std::max(s.scope_peak, s.live);
+
+    MemStatsEntry &e = s.entry(tag);
+    e.count++; e.bytes += bytes; e.live += bytes; e.peak = std::max(e.peak, e.live);
+
+    // Keep largest allocations (sorted descending):
+    if ((s.largest.size() < LINALG_MEMSTATS_TOP) || (s.largest.back().second < bytes)) {
+      std::pair<const char *, size_t> item(tag, bytes);
+      s.largest.insert(std::upper_bound(s.largest.begin(), s.largest.end(), item, __larger),
+                       item);
+      if (s.largest.size() > LINALG_MEMSTATS_TOP) { s.largest.pop_back(); }
+    }
+    return tag;
+#else
+    (void)bytes;
+    return kind;
+#endif
+  }
+
+  /**
+   * Records the release of @c bytes, allocated under the given tag.
+   */
+  static inline void released(size_t bytes, const char *tag) {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    State &s = state();
+    s.live -= std::min(s.live, bytes);
+    MemStatsEntry &e = s.entry(tag);
+    e.live -= std::min(e.live, bytes);
+#else
+    (void)bytes; (void)tag;
+#endif
+  }
+
+  /** Returns the number of bytes currently allocated. */
+  static inline size_t live() {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().live;
+#else
+    return 0;
+#endif
+  }
+
+  /** Returns the maximum number of bytes allocated at any time. */
+  static inline size_t peak() {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().peak;
+#else
+    return 0;
+#endif
+  }
+
+  /** Returns the total number of allocations. */
+  static inline size_t count() {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().count;
+#else
+    return 0;
+#endif
+  }
+
+  /** Returns the counters of the given tag (all zero if the tag is unknown). */
+  static inline MemStatsEntry entry(const char *tag) {
+    MemStatsEntry e = { tag, 0, 0, 0, 0 };
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    std::map<std::string, MemStatsEntry>::iterator it = state().tags.find(tag);
+    if (state().tags.end() != it) { e = it->second; }
+#endif
+    return e;
+  }
+
+  /** Returns the size of the largest allocation (0 if there was none). */
+  static inline size_t largest() {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    return state().largest.empty() ? 0 : state().largest.front().second;
+#else
+    return 0;
+#endif
+  }
+
+  /**
+   * Resets the peak and the counters, keeping the live bytes.
+   */
+  static inline void reset() {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    State &s = state();
+    s.count = s.bytes = 0; s.peak = s.scope_peak = s.live; s.largest.clear();
+    for (std::map<std::string, MemStatsEntry>::iterator it=s.tags.begin(); it!=s.tags.end(); it++) {
+      it->second.count = it->second.bytes = 0; it->second.peak = it->second.live;
+    }
+#endif
+  }
+
+  /**
+   * Writes a report of all counters to the given stream.
+   */
+  static inline void dump(std::ostream &stream) {
+#ifdef LINALG_MEMSTATS
+    std::lock_guard<std::mutex> lock(state().mutex);
+    State &s = state();
+    stream << "Linalg memory: " << s.live << " bytes live, " << s.peak << " bytes peak, "
+           << s.count << " allocations (" << s.bytes << " bytes)" << std::endl;
+    for (std::map<std::string, MemStatsEntry>::iterator it=s.tags.begin(); it!=s.tags.end(); it++) {
+      stream << "  " << it->first << ": " << it->second.count << " allocations, "
+             << it->second.bytes << " bytes, " << it->second.live << " live, "
+             << it->second.peak << " peak" << std::endl;
+    }
+    stream << "  largest allocations:";
+    for (size_t i=0; i<s.largest.size(); i++) {
+      stream << " " << s.largest[i].second << " (" << s.largest[i].first << ")";
+    }
+    stream << std::endl;
+#else
+    stream << "Linalg memory statistics disabled, define LINALG_MEMSTATS." << std::endl;
+#endif
+  }
+
+
+protected:
+  /** Returns the tag of the calling thread. */
+  static inline const char *&currentTag() {
+    static thread_local const char *tag = 0;
+    return tag;
+  }
+
+#ifdef LINALG_MEMSTATS
+  /** The global state. */
+  struct State {
+    /** Protects the state. */
+    std::mutex mutex;
+    /** Total number of allocations. */
+    size_t count;
+    /** Total number of bytes allocated. */
+    size_t bytes;
+    /** Bytes currently allocated. */
+    size_t live;
+    /** Maximum of @c live. */
+    size_t peak;
+    /** Maximum of @c live within the innermost @c Scope. */
+    size_t scope_peak;
+    /** Counters per tag. */
+    std::map<std::string, MemStatsEntry> tags;
+    /** The largest allocations (tag, bytes), sorted descending. */
+    std::vector< std::pair<const char *, size_t> > largest;
+
+    State() : count(0), bytes(0), live(0), peak(0), scope_peak(0) { }
+
+    /** Returns the entry for the given tag. */
+    MemStatsEntry &entry(const char *tag) {
+      std::map<std::string, MemStatsEntry>::iterator it = tags.find(tag);
+      if (tags.end() == it) {
+        MemStatsEntry e = { tag, 0, 0, 0, 0 };
+        it = tags.insert(std::make_pair(std::string(tag), e)).first;
+      }
+      return it->second;
+    }
+  };
+
+  /** Returns the global state (never destroyed, arrays may be freed during program exit). */
+  static inline State &state() {
+    static State *s = new State();
+    return *s;
+  }
+
+  /** Orders the largest allocations descending. */
+  static inline bool __larger(const std::pair<const char *, size_t> &a,
+                              const std::pair<const char *, size_t> &b) {
+    return a.second > b.second;
+  }
+#endif
+};
+
+
+}
+
+#endif // __LINALG_MEMSTATS_HH__
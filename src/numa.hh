@@ -0,0 +1,185 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_NUMA_HH__
+#define __LINALG_NUMA_HH__
+
+#include "openmp.hh"
+#include <cstddef>
+
+#ifdef LINALG_HAS_NUMA
+#include <numa.h>
+#include <unistd.h>
+#endif
+
+
+namespace Linalg {
+
+/**
+ * Controls the placement of the memory of newly allocated arrays, matrices and vectors on NUMA
+ * machines.
+ *
+ * Linux places a page on the NUMA node of the thread that touches it first. By default
+ * (@c FIRST_TOUCH), the factories @c Matrix::zeros, @c Vector::zero and the @c rand factories
+ * therefore initialize the memory in parallel, using the same static partition as an OpenMP
+ * loop @c "#pragma omp parallel for schedule(static)" over the rows (row-major) or columns
+ * (column-major) of the matrix, or the elements of the vector. Compute loops partitioned the
+ * same way then access node-local memory. The @c SERIAL policy restores the single-threaded
+ * initialization.
+ *
+ * If the library is compiled with @c LINALG_HAS_NUMA defined (and linked against libnuma), the
+ * policies @c INTERLEAVE (interleave pages round-robin over all nodes) and @c BIND (place all
+ * pages on a single node) are applied explicitly to each new array, matrix and vector. These
+ * policies only affect pages, that have not been touched yet, i.e. memory that was not recycled
+ * by the @c MemoryPool (e.g. large matrices). Without libnuma, both fall back to @c FIRST_TOUCH.
+ *
+ * @ingroup matrix
+ */
+class NUMA
+{
+public:
+  /** The placement policies. */
+  typedef enum {
+    SERIAL,       ///< Single-threaded initialization, all pages end up on one node.
+    FIRST_TOUCH,  ///< Parallel first-touch initialization (default).
+    INTERLEAVE,   ///< Interleave pages over all nodes (needs libnuma).
+    BIND          ///< Bind pages to a node (needs libnuma).
+  } Policy;
+
+  /**
+   * Sets the placement policy for the lifetime of the scope and restores the previous one on
+   * destruction.
+   */
+  class Scope
+  {
+  protected:
+    /** The previous policy. */
+    Policy _policy;
+    /** The previous node. */
+    int _node;
+
+  public:
+    /** Sets the given policy. */
+    Scope(Policy policy, int node=0)
+      : _policy(NUMA::policy()), _node(NUMA::node())
+    {
+      NUMA::setPolicy(policy, node);
+    }
+
+    /** Restores the previous policy. */
+    ~Scope() {
+      NUMA::setPolicy(_policy, _node);
+    }
+  };
+
+
+public:
+  /** Returns true if libnuma is available at compile- and runtime. */
+  static inline bool available() {
+#ifdef LINALG_HAS_NUMA
+    return numa_available() >= 0;
+#else
+    return false;
+#endif
+  }
+
+  /** Returns the current placement policy. */
+  static inline Policy policy() {
+    return state()._policy;
+  }
+
+  /** Returns the node used by the @c BIND policy. */
+  static inline int node() {
+    return state()._node;
+  }
+
+  /** Sets the placement policy (and the node for @c BIND). */
+  static inline void setPolicy(Policy policy, int node=0) {
+    state()._policy = policy; state()._node = node;
+  }
+
+  /** Returns true if the memory is initialized in parallel by the current policy. */
+  static inline bool parallel() {
+#ifdef LINALG_HAS_OPENMP
+    return (SERIAL != policy()) && (1 < OpenMP::getMaxThreads());
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Applies the explicit policies @c INTERLEAVE or @c BIND to the given memory region. Does
+   * nothing for the other policies or if libnuma is not available.
+   */
+  static inline void place(void *ptr, size_t bytes) {
+#ifdef LINALG_HAS_NUMA
+    if ((0 == bytes) || ((INTERLEAVE != policy()) && (BIND != policy())) || (! available())) {
+      return;
+    }
+
+    // Policies can only be applied to whole pages:
+    size_t page  = sysconf(_SC_PAGESIZE);
+    size_t begin = ((reinterpret_cast<size_t>(ptr) + page - 1)/page)*page;
+    size_t end   = ((reinterpret_cast<size_t>(ptr) + bytes)/page)*page;
+    if (begin >= end) {
+      return;
+    }
+
+    if (INTERLEAVE == policy()) {
+      numa_interleave_memory(reinterpret_cast<void *>(begin), end-begin, numa_all_nodes_ptr);
+    } else {
+      numa_tonode_memory(reinterpret_cast<void *>(begin), end-begin, node());
+    }
+#else
+    (void)ptr; (void)bytes;
+#endif
+  }
+
+
+protected:
+  /** The global state. */
+  struct State {
+    /** The current policy. */
+    Policy _policy;
+    /** The node for @c BIND. */
+    int _node;
+  };
+
+  /** Returns the global state. */
+  static inline State &state() {
+    static State s = { FIRST_TOUCH, 0 };
+    return s;
+  }
+};
+
+
+/**
+ * Fills the strided 2D block at @c ptr with @c value, where the @c outer dimension has the
+ * stride @c ld and the @c inner dimension is contiguous. If requested by the current
+ * @c NUMA::policy() and if the block is large enough (see @c OpenMP::runParallel), the outer
+ * dimension is partitioned statically over all threads, such that each thread first-touches
+ * the pages it will later work on.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline void
+__first_touch(Scalar *ptr, size_t outer, size_t inner, size_t ld, Scalar value)
+{
+  bool parallel = NUMA::parallel() && OpenMP::runParallel(outer*inner); (void)parallel;
+#pragma omp parallel for schedule(static) if(parallel)
+  for (size_t i=0; i<outer; i++) {
+    Scalar *row = ptr + i*ld;
+    for (size_t j=0; j<inner; j++) { row[j] = value; }
+  }
+}
+
+
+}
+
+#endif // __LINALG_NUMA_HH__
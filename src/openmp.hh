@@ -16,6 +16,14 @@
 #define LINALG_HAS_OPENMP
 #endif
 
+/**
+ * Default minimum number of elements of an element-wise operation, that is split across
+ * threads, see @c OpenMP::setParallelThreshold.
+ */
+#ifndef LINALG_PARALLEL_THRESHOLD
+#define LINALG_PARALLEL_THRESHOLD 65536
+#endif
+
 /**
  * Simple wrapper class to encapsulate OpenMP.
  */
@@ -43,6 +51,52 @@ public:
 #endif
     return 0;
   }
+
+  /**
+   * Returns the number of threads in the current team or 1 if OpenMP is disabled.
+   */
+  static size_t getNumThreads() {
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#endif
+    return 1;
+  }
+
+  /**
+   * Returns the minimum number of elements of an element-wise operation to run in parallel.
+   */
+  static inline size_t getParallelThreshold() {
+    return threshold();
+  }
+
+  /**
+   * Sets the minimum number of elements of an element-wise operation (assignment, fill,
+   * comparison, expression evaluation) to be split across threads. Smaller operations run
+   * serially, as the overhead of the parallel region exceeds the gain.
+   */
+  static inline void setParallelThreshold(size_t elements) {
+    threshold() = elements;
+  }
+
+  /**
+   * Returns true if an element-wise operation of the given size should run in parallel, i.e.
+   * if OpenMP is enabled, more than one thread is available, the size exceeds the threshold
+   * and the caller is not already running in a parallel region.
+   */
+  static inline bool runParallel(size_t elements) {
+#ifdef _OPENMP
+    return (elements >= threshold()) && (1 < omp_get_max_threads()) && (! omp_in_parallel());
+#endif
+    (void)elements;
+    return false;
+  }
+
+protected:
+  /** Holds the threshold. */
+  static inline size_t &threshold() {
+    static size_t elements = LINALG_PARALLEL_THRESHOLD;
+    return elements;
+  }
 };
 
 #endif
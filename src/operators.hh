@@ -21,6 +21,7 @@
 #include "vector_operators.hh"
 #include "matrix_operators.hh"
 #include "trimatrix_operators.hh"
+#include "reduce.hh"
 
 
 #endif // __LINALG_OPERATORS_HH__
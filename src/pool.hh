@@ -0,0 +1,339 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_POOL_HH__
+#define __LINALG_POOL_HH__
+
+#include "exception.hh"
+#include <cstdlib>
+#include <atomic>
+
+
+/**
+ * Specifies the alignment (in bytes) of all memory allocated by @c Linalg::DataMngr. This
+ * matches the cache-line size of common x86 CPUs and is a multiple of all SIMD vector sizes.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_ALIGNMENT
+#define LINALG_ALIGNMENT 64
+#endif
+
+/**
+ * Specifies the maximum number of bytes, each thread keeps in its cache of free blocks outside
+ * of a @c Linalg::MemoryPool::Scope.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_POOL_MAX_CACHED
+#define LINALG_POOL_MAX_CACHED (64*1024*1024)
+#endif
+
+
+namespace Linalg {
+
+/**
+ * Allocates @c bytes of memory aligned to @c LINALG_ALIGNMENT.
+ *
+ * @throws MemoryError If the memory can not be allocated.
+ *
+ * @ingroup matrix
+ */
+inline void *__aligned_malloc(size_t bytes)
+{
+  void *ptr = 0;
+  if (0 != posix_memalign(&ptr, LINALG_ALIGNMENT, (0 == bytes) ? 1 : bytes)) {
+    MemoryError err;
+    err << "Can not allocate " << bytes << " bytes of aligned memory.";
+    throw err;
+  }
+
+  return ptr;
+}
+
+
+/**
+ * Frees the memory allocated by @c __aligned_malloc.
+ *
+ * @ingroup matrix
+ */
+inline void __aligned_free(void *ptr)
+{
+  free(ptr);
+}
+
+
+/**
+ * Returns true if the given pointer is aligned to the given alignment (in bytes).
+ *
+ * @ingroup matrix
+ */
+inline bool __is_aligned(const void *ptr, size_t alignment=LINALG_ALIGNMENT)
+{
+  return 0 == (reinterpret_cast<size_t>(ptr) % alignment);
+}
+
+
+
+/**
+ * Counters of the @c MemoryPool, see @c MemoryPool::stats().
+ *
+ * @ingroup matrix
+ */
+struct PoolStats
+{
+  /** Number of allocations served from a thread cache. */
+  size_t hits;
+  /** Number of pooled allocations, that needed a fresh block from the system. */
+  size_t misses;
+  /** Number of allocations too large to be pooled. */
+  size_t unpooled;
+  /** Number of blocks returned to a thread cache. */
+  size_t recycled;
+  /** Number of blocks returned to the system. */
+  size_t released;
+
+  /** Returns the fraction of pooled allocations, that were served from a thread cache. */
+  inline double hitRate() const {
+    return (0 == (hits+misses)) ? 0.0 : double(hits)/(hits+misses);
+  }
+};
+
+
+
+/**
+ * A thread-caching, size-class pool allocator for the array memory.
+ *
+ * Allocations are rounded up to power-of-two size classes starting at @c LINALG_ALIGNMENT
+ * bytes. Freed blocks are kept in a free-list per size class and thread, hence the frequent
+ * allocation of same-shaped temporaries (e.g. by @c operator* or @c Array::copy) does not touch
+ * the system allocator after the first iteration. Each thread caches at most
+ * @c LINALG_POOL_MAX_CACHED bytes, unless a @c MemoryPool::Scope is active, see there.
+ *
+ * Blocks may be freed by a different thread than the one that allocated them. Defining
+ * @c LINALG_NO_POOL bypasses the pool completely.
+ *
+ * @ingroup matrix
+ */
+class MemoryPool
+{
+public:
+  /** The size (in bytes) of the smallest size class. */
+  static const size_t min_block_size = LINALG_ALIGNMENT;
+  /** The number of size classes, allocations larger than the largest class are not pooled. */
+  static const size_t num_classes = 20;
+
+  /**
+   * Marks a region, in which all freed blocks are retained by the calling thread (arena). On
+   * destruction, the thread cache is trimmed back to @c LINALG_POOL_MAX_CACHED bytes. Scopes
+   * may be nested.
+   */
+  class Scope
+  {
+  public:
+    /** Opens the scope for the calling thread. */
+    Scope() { MemoryPool::cache()._scopes++; }
+    /** Closes the scope and trims the thread cache. */
+    ~Scope() {
+      ThreadCache &tc = MemoryPool::cache();
+      if (0 == --tc._scopes) { tc.trim(LINALG_POOL_MAX_CACHED); }
+    }
+  };
+
+
+protected:
+  /** A free block, the link to the next block is stored in the block itself. */
+  struct Block {
+    /** The next free block of the same size class. */
+    Block *next;
+  };
+
+  /**
+   * Per-thread cache of free blocks. This is a POD type, such that the thread-local instance is
+   * zero-initialized and stays accessible during thread (and program) termination.
+   */
+  struct ThreadCache
+  {
+    /** The free lists, one for each size class. */
+    Block *_free[num_classes];
+    /** The number of bytes held in the free lists. */
+    size_t _cached;
+    /** The number of active scopes. */
+    size_t _scopes;
+    /** If true, the cleanup of the cache at thread exit has been registered. */
+    bool _registered;
+    /** If true, the thread is terminating, blocks are no longer cached. */
+    bool _dead;
+
+    /** Returns cached blocks to the system, until at most @c max_bytes are cached. */
+    void trim(size_t max_bytes) {
+      // Release largest blocks first:
+      for (size_t c=num_classes; (c>0) && (_cached>max_bytes); c--) {
+        while ((0 != _free[c-1]) && (_cached > max_bytes)) {
+          Block *block = _free[c-1]; _free[c-1] = block->next;
+          _cached -= MemoryPool::classSize(c-1);
+          __aligned_free(block);
+          MemoryPool::count(RELEASED);
+        }
+      }
+    }
+  };
+
+  /**
+   * Releases the thread cache at thread exit.
+   */
+  struct CacheGuard
+  {
+    /** Releases all cached blocks and marks the cache dead. */
+    ~CacheGuard() {
+      ThreadCache &tc = MemoryPool::cache();
+      tc.trim(0); tc._dead = true;
+    }
+  };
+
+  /** Indices of the global counters. */
+  typedef enum {
+    HITS=0, MISSES, UNPOOLED, RECYCLED, RELEASED, NUM_COUNTERS
+  } Counter;
+
+
+public:
+  /**
+   * Returns the size class for an allocation of @c bytes or @c num_classes if the allocation
+   * is too large to be pooled.
+   */
+  static inline size_t sizeClass(size_t bytes) {
+    size_t c = 0, size = min_block_size;
+    while ((size < bytes) && (c < num_classes)) { size <<= 1; c++; }
+    return c;
+  }
+
+  /** Returns the block size (in bytes) of the given size class. */
+  static inline size_t classSize(size_t c) {
+    return min_block_size << c;
+  }
+
+  /**
+   * Allocates @c bytes of memory aligned to @c LINALG_ALIGNMENT. The memory must be freed with
+   * @c MemoryPool::free passing the same size.
+   *
+   * @throws MemoryError If the memory can not be allocated.
+   */
+  static inline void *alloc(size_t bytes)
+  {
+#ifdef LINALG_NO_POOL
+    return __aligned_malloc(bytes);
+#else
+    size_t c = sizeClass(bytes);
+    if (num_classes == c) {
+      count(UNPOOLED);
+      return __aligned_malloc(bytes);
+    }
+
+    // Try to serve from cache:
+    ThreadCache &tc = cache();
+    if ((! tc._dead) && (0 != tc._free[c])) {
+      Block *block = tc._free[c]; tc._free[c] = block->next;
+      tc._cached -= classSize(c);
+      count(HITS);
+      return block;
+    }
+
+    count(MISSES);
+    return __aligned_malloc(classSize(c));
+#endif
+  }
+
+  /**
+   * Returns the memory allocated by @c MemoryPool::alloc.
+   */
+  static inline void free(void *ptr, size_t bytes)
+  {
+#ifdef LINALG_NO_POOL
+    __aligned_free(ptr);
+#else
+    size_t c = sizeClass(bytes);
+    ThreadCache &tc = cache();
+    if ((num_classes == c) || tc._dead ||
+        ((0 == tc._scopes) && (tc._cached+classSize(c) > LINALG_POOL_MAX_CACHED))) {
+      if (num_classes != c) { count(RELEASED); }
+      __aligned_free(ptr);
+      return;
+    }
+
+    Block *block = reinterpret_cast<Block *>(ptr);
+    block->next = tc._free[c]; tc._free[c] = block;
+    tc._cached += classSize(c);
+    count(RECYCLED);
+#endif
+  }
+
+  /**
+   * Returns all blocks cached by the calling thread to the system.
+   */
+  static inline void trim() {
+    cache().trim(0);
+  }
+
+  /**
+   * Returns the number of bytes cached by the calling thread.
+   */
+  static inline size_t cached() {
+    return cache()._cached;
+  }
+
+  /**
+   * Returns the counters (summed over all threads).
+   */
+  static inline PoolStats stats() {
+    PoolStats s;
+    s.hits     = counter(HITS);
+    s.misses   = counter(MISSES);
+    s.unpooled = counter(UNPOOLED);
+    s.recycled = counter(RECYCLED);
+    s.released = counter(RELEASED);
+    return s;
+  }
+
+  /**
+   * Resets all counters.
+   */
+  static inline void resetStats() {
+    for (size_t i=0; i<NUM_COUNTERS; i++) {
+      counter(Counter(i)).store(0, std::memory_order_relaxed);
+    }
+  }
+
+
+protected:
+  /** Returns the cache of the calling thread. */
+  static inline ThreadCache &cache() {
+    static thread_local ThreadCache tc;
+    if (! tc._registered) {
+      tc._registered = true;
+      static thread_local CacheGuard guard; (void)guard;
+    }
+    return tc;
+  }
+
+  /** Increments the specified global counter. */
+  static inline void count(Counter c) {
+    counter(c).fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Returns a reference to the specified global counter. */
+  static inline std::atomic<size_t> &counter(Counter c) {
+    static std::atomic<size_t> counters[NUM_COUNTERS];
+    return counters[c];
+  }
+};
+
+
+}
+
+#endif // __LINALG_POOL_HH__
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_RANDOM_HH__
+#define __LINALG_RANDOM_HH__
+
+#include "openmp.hh"
+#include "numa.hh"
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+
+
+/**
+ * Default seed of the random numbers, see @c Random::seed.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_RANDOM_SEED
+#define LINALG_RANDOM_SEED 0x853c49e6748fea9bULL
+#endif
+
+
+namespace Linalg {
+
+/**
+ * The counter-based random number generator Philox4x32-10 (Salmon et al., "Parallel random
+ * numbers: As easy as 1, 2, 3", SC 2011).
+ *
+ * The generator has no state besides its key (the seed) and the stream: It maps a 64-bit
+ * counter to 128 random bits by ten rounds of a bijection. Hence, the n-th random number can
+ * be computed directly, which allows to fill arrays in parallel with results that do not
+ * depend on the number of threads. Different streams of the same seed are independent.
+ *
+ * @ingroup matrix
+ */
+class Philox
+{
+protected:
+  /** The key. */
+  uint32_t _key[2];
+  /** The stream (upper half of the counter). */
+  uint32_t _stream[2];
+
+public:
+  /** Constructs the generator for the given seed and stream. */
+  explicit Philox(uint64_t seed, uint64_t stream=0)
+  {
+    _key[0] = uint32_t(seed); _key[1] = uint32_t(seed >> 32);
+    _stream[0] = uint32_t(stream); _stream[1] = uint32_t(stream >> 32);
+  }
+
+  /** Computes the 4 random words of the given counter. */
+  inline void operator() (uint64_t counter, uint32_t *out) const
+  {
+    uint32_t c0 = uint32_t(counter), c1 = uint32_t(counter >> 32);
+    uint32_t c2 = _stream[0], c3 = _stream[1];
+    uint32_t k0 = _key[0], k1 = _key[1];
+    for (int r=0; r<10; r++) {
+      uint64_t p0 = uint64_t(0xD2511F53) * c0, p1 = uint64_t(0xCD9E8D57) * c2;
+      uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0, n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+      c0 = n0; c1 = uint32_t(p1); c2 = n2; c3 = uint32_t(p0);
+      k0 += 0x9E3779B9; k1 += 0xBB67AE85;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+  }
+
+  /**
+   * Computes the @c 2*n uniform numbers in [0,1) with 53 random bits of the counters
+   * [counter, counter+n) into @c out.
+   */
+  inline void uniform(uint64_t counter, size_t n, double *out) const
+  {
+    uint32_t r[4];
+    for (size_t i=0; i<n; i++) {
+      (*this)(counter+i, r);
+      out[2*i]   = double(((uint64_t(r[0]) << 32) | r[1]) >> 11) / 9007199254740992.0;
+      out[2*i+1] = double(((uint64_t(r[2]) << 32) | r[3]) >> 11) / 9007199254740992.0;
+    }
+  }
+
+  /**
+   * Computes the @c 2*n standard normal distributed numbers of the counters
+   * [counter, counter+n) into @c out, by the Box-Muller transform of the uniform numbers.
+   */
+  inline void normal(uint64_t counter, size_t n, double *out) const
+  {
+    uniform(counter, n, out);
+    for (size_t i=0; i<n; i++) {
+      double r = std::sqrt(-2.0*std::log(1.0 - out[2*i])), phi = 6.283185307179586*out[2*i+1];
+      out[2*i] = r*std::cos(phi); out[2*i+1] = r*std::sin(phi);
+    }
+  }
+};
+
+
+/**
+ * Holds the global seed and stream counter of the random numbers of @c Matrix::rand and
+ * @c Vector::rand (without an explicit seed).
+ *
+ * Every call draws a new stream of the global seed, hence subsequent calls return different
+ * numbers, but the sequence of calls is reproducible after @c Random::seed.
+ *
+ * @ingroup matrix
+ */
+class Random
+{
+public:
+  /** Sets the global seed and restarts the streams. */
+  static inline void seed(uint64_t seed) {
+    state().seed.store(seed); state().stream.store(0);
+  }
+
+  /** Returns a generator for the next stream of the global seed. */
+  static inline Philox next() {
+    return Philox(state().seed.load(), state().stream.fetch_add(1));
+  }
+
+protected:
+  /** The global state. */
+  struct State {
+    /** The seed. */
+    std::atomic<uint64_t> seed;
+    /** The next stream. */
+    std::atomic<uint64_t> stream;
+
+    State() : seed(LINALG_RANDOM_SEED), stream(0) { }
+  };
+
+  /** Returns the global state. */
+  static inline State &state() {
+    static State s;
+    return s;
+  }
+};
+
+
+/**
+ * Fills the strided @c rows x @c cols block at @c ptr with uniform [0,1) (or standard normal if
+ * @c normal is true) random numbers of the given generator.
+ *
+ * The element (i,j) receives the number @c i*cols+j of the generator, independent of the
+ * storage order and the number of threads. The numbers are generated in batches (a loop
+ * without branches, that the compiler can vectorize) and large blocks are split into equal
+ * ranges of elements, one per thread, unless the @c NUMA policy requests a serial first touch.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline void
+__random_fill(Scalar *ptr, size_t rows, size_t cols, size_t rs, size_t cs,
+              const Philox &gen, bool normal)
+{
+  const size_t n = rows*cols;
+  if (0 == n) { return; }
+
+  auto fill = [&](size_t begin, size_t end) {
+    const size_t B = 64;
+    double buffer[B];
+    size_t i = begin / cols, j = begin % cols;
+    for (size_t k0=(begin & ~size_t(1)); k0<end; k0+=B) {
+      if (normal) { gen.normal(k0/2, B/2, buffer); }
+      else { gen.uniform(k0/2, B/2, buffer); }
+      for (size_t k=std::max(k0, begin); k<std::min(k0+B, end); k++) {
+        ptr[i*rs + j*cs] = Scalar(buffer[k-k0]);
+        if (cols == ++j) { j = 0; i++; }
+      }
+    }
+  };
+
+  if (! (NUMA::parallel() && OpenMP::runParallel(n))) {
+    fill(0, n);
+    return;
+  }
+
+#pragma omp parallel
+  {
+    size_t nt = OpenMP::getNumThreads(), t = OpenMP::getThreadNum();
+    size_t chunk = ((n + nt - 1)/nt + 63) & ~size_t(63);
+    size_t begin = std::min(n, t*chunk), end = std::min(n, begin+chunk);
+    if (begin < end) { fill(begin, end); }
+  }
+}
+
+
+}
+
+#endif // __LINALG_RANDOM_HH__
@@ -0,0 +1,628 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_REDUCE_HH__
+#define __LINALG_REDUCE_HH__
+
+#include "array.hh"
+#include "matrix.hh"
+#include "vector.hh"
+#include "expression.hh"
+#include "simd.hh"
+#include <vector>
+#include <utility>
+#include <cmath>
+
+
+namespace Linalg {
+
+/*
+ * Line kernels: Each kernel reduces the n elements x[0], x[inc], ..., x[(n-1)*inc]. The dense
+ * kernels (inc == 1) of the SIMD types use four independent vector accumulators, such that
+ * consecutive vector operations do not wait for each other. The generic kernels use four scalar
+ * accumulators.
+ */
+
+/**
+ * Sums dense elements using SIMD instructions, where @c VecType specifies the (aligned or
+ * unaligned) SIMD vector union used to access the elements.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, class VecType>
+inline Scalar __sum_dense_simd(size_t N, const Scalar *x)
+{
+  const size_t N_elm = SIMDTraits<Scalar>::num_elements;
+  const VecType *x_ptr = (const VecType *)x;
+  size_t N_step = N/(4*N_elm);
+
+  VecType acc[4];
+  for (size_t k=0; k<4; k++) {
+    for (size_t i=0; i<N_elm; i++) { acc[k].d[i] = Scalar(0); }
+  }
+
+  for (size_t i=0; i<N_step; i++, x_ptr+=4) {
+    acc[0].v += x_ptr[0].v; acc[1].v += x_ptr[1].v;
+    acc[2].v += x_ptr[2].v; acc[3].v += x_ptr[3].v;
+  }
+
+  acc[0].v += acc[1].v; acc[2].v += acc[3].v; acc[0].v += acc[2].v;
+  Scalar res = Scalar(0);
+  for (size_t i=0; i<N_elm; i++) { res += acc[0].d[i]; }
+
+  // Remaining elements:
+  for (size_t i=N_step*4*N_elm; i<N; i++) { res += x[i]; }
+  return res;
+}
+
+
+/**
+ * Determines the minimum (@c MAX = false) or maximum (@c MAX = true) of dense elements using
+ * SIMD instructions. If @c ABS is true, the absolute values are compared. @c N must be > 0.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, class VecType, bool MAX, bool ABS>
+inline Scalar __extremum_dense_simd(size_t N, const Scalar *x)
+{
+  const size_t N_elm = SIMDTraits<Scalar>::num_elements;
+  const VecType *x_ptr = (const VecType *)x;
+  size_t N_step = N/(4*N_elm);
+
+  Scalar res = ABS ? std::abs(x[0]) : x[0];
+  VecType acc[4];
+  for (size_t k=0; k<4; k++) {
+    for (size_t i=0; i<N_elm; i++) { acc[k].d[i] = res; }
+  }
+
+  for (size_t i=0; i<N_step; i++, x_ptr+=4) {
+    for (size_t k=0; k<4; k++) {
+      VecType v = x_ptr[k];
+      if (ABS) { v.v = (v.v < 0) ? -v.v : v.v; }
+      if (MAX) { acc[k].v = (v.v > acc[k].v) ? v.v : acc[k].v; }
+      else { acc[k].v = (v.v < acc[k].v) ? v.v : acc[k].v; }
+    }
+  }
+
+  for (size_t k=0; k<4; k++) {
+    for (size_t i=0; i<N_elm; i++) {
+      res = MAX ? std::max(res, acc[k].d[i]) : std::min(res, acc[k].d[i]);
+    }
+  }
+
+  // Remaining elements:
+  for (size_t i=N_step*4*N_elm; i<N; i++) {
+    Scalar v = ABS ? std::abs(x[i]) : x[i];
+    res = MAX ? std::max(res, v) : std::min(res, v);
+  }
+  return res;
+}
+
+
+/**
+ * Generic sum of strided elements.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar __sum_line(const Scalar *x, size_t n, size_t inc, std::false_type)
+{
+  Scalar s0(0), s1(0), s2(0), s3(0);
+  size_t i = 0;
+  for (; i+4<=n; i+=4, x+=4*inc) {
+    s0 += x[0]; s1 += x[inc]; s2 += x[2*inc]; s3 += x[3*inc];
+  }
+  for (; i<n; i++, x+=inc) { s0 += *x; }
+  return (s0+s1) + (s2+s3);
+}
+
+/** Sum of strided elements, uses SIMD instructions for dense elements. */
+template <class Scalar>
+inline Scalar __sum_line(const Scalar *x, size_t n, size_t inc, std::true_type)
+{
+  if (1 != inc) { return __sum_line(x, n, inc, std::false_type()); }
+
+  // Prologue up to the alignment boundary:
+  size_t p = __simd_peel(x, n);
+  Scalar res = __sum_line(x, p, 1, std::false_type());
+  x += p; n -= p;
+  if (__is_simd_aligned(x)) {
+    return res + __sum_dense_simd<Scalar, typename SIMDTraits<Scalar>::auvector>(n, x);
+  }
+  return res + __sum_dense_simd<Scalar, typename SIMDTraits<Scalar>::uvector>(n, x);
+}
+
+/** Sum of strided elements. */
+template <class Scalar>
+inline Scalar __sum_line(const Scalar *x, size_t n, size_t inc)
+{
+  return __sum_line(x, n, inc, __has_simd<Scalar>());
+}
+
+
+/**
+ * Generic minimum/maximum of (absolute values of) strided elements, @c n must be > 0.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, bool MAX, bool ABS>
+inline Scalar __extremum_line(const Scalar *x, size_t n, size_t inc, std::false_type)
+{
+  Scalar r[4];
+  for (size_t k=0; k<4; k++) { r[k] = ABS ? std::abs(x[0]) : x[0]; }
+  size_t i = 0;
+  for (; i+4<=n; i+=4, x+=4*inc) {
+    for (size_t k=0; k<4; k++) {
+      Scalar v = ABS ? std::abs(x[k*inc]) : x[k*inc];
+      r[k] = MAX ? std::max(r[k], v) : std::min(r[k], v);
+    }
+  }
+  for (; i<n; i++, x+=inc) {
+    Scalar v = ABS ? std::abs(*x) : *x;
+    r[0] = MAX ? std::max(r[0], v) : std::min(r[0], v);
+  }
+  for (size_t k=1; k<4; k++) { r[0] = MAX ? std::max(r[0], r[k]) : std::min(r[0], r[k]); }
+  return r[0];
+}
+
+/** Minimum/maximum of strided elements, uses SIMD instructions for dense elements. */
+template <class Scalar, bool MAX, bool ABS>
+inline Scalar __extremum_line(const Scalar *x, size_t n, size_t inc, std::true_type)
+{
+  if (1 != inc) { return __extremum_line<Scalar, MAX, ABS>(x, n, inc, std::false_type()); }
+
+  // Prologue up to the alignment boundary (the kernel needs at least one element):
+  size_t p = std::min(__simd_peel(x, n), n-1);
+  Scalar res = ABS ? std::abs(x[0]) : x[0];
+  for (size_t i=1; i<p; i++) {
+    Scalar v = ABS ? std::abs(x[i]) : x[i];
+    res = MAX ? std::max(res, v) : std::min(res, v);
+  }
+  x += p; n -= p;
+
+  Scalar r;
+  if (__is_simd_aligned(x)) {
+    r = __extremum_dense_simd<Scalar, typename SIMDTraits<Scalar>::auvector, MAX, ABS>(n, x);
+  } else {
+    r = __extremum_dense_simd<Scalar, typename SIMDTraits<Scalar>::uvector, MAX, ABS>(n, x);
+  }
+  return MAX ? std::max(res, r) : std::min(res, r);
+}
+
+/** Minimum/maximum of (absolute values of) strided elements, @c n must be > 0. */
+template <class Scalar, bool MAX, bool ABS>
+inline Scalar __extremum_line(const Scalar *x, size_t n, size_t inc)
+{
+  return __extremum_line<Scalar, MAX, ABS>(x, n, inc, __has_simd<Scalar>());
+}
+
+
+/** Sum of two values. */
+struct __reduce_add {
+  template <class T> inline T operator() (const T &a, const T &b) const { return a+b; }
+};
+
+/** Minimum (@c MAX = false) or maximum (@c MAX = true) of two values. */
+template <bool MAX>
+struct __reduce_extremum {
+  template <class T> inline T operator() (const T &a, const T &b) const {
+    return MAX ? std::max(a, b) : std::min(a, b);
+  }
+};
+
+/** Minimum/maximum of two (value, position) pairs, the first position wins ties. */
+template <bool MAX>
+struct __reduce_argextremum {
+  template <class T> inline T operator() (const T &a, const T &b) const {
+    if (MAX ? (b.first > a.first) : (b.first < a.first)) { return b; }
+    if ((b.first == a.first) && (b.second < a.second)) { return b; }
+    return a;
+  }
+};
+
+
+/**
+ * Reduces all elements addressed by the given loop over the array at @c ptr. @c line(x, n,
+ * inc, pos) reduces a line of @c n elements, where @c pos is the position of the first element
+ * in loop order, and @c combine(a, b) combines two partial results. Large loops are split
+ * across threads, the partial results are combined in a fixed order.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, class Result, class Line, class Combine>
+inline Result
+__reduce(const StridedLoop<1> &loop, const Scalar *ptr, const Result &init, Line line,
+         Combine combine)
+{
+  size_t nthreads = OpenMP::runParallel(loop.size()) ? OpenMP::getMaxThreads() : 1;
+  std::vector<Result> partial(nthreads, init);
+
+#pragma omp parallel num_threads(nthreads) if(1 < nthreads)
+  {
+    size_t begin, end;
+    loop.partition(OpenMP::getThreadNum(), OpenMP::getNumThreads(), begin, end);
+    Result res = init; size_t pos = begin;
+    size_t inc = loop.innerStride(0);
+    auto func = [&](const size_t *offsets, size_t n) {
+      res = combine(res, line(ptr + offsets[0], n, inc, pos)); pos += n;
+    };
+    loop.run(func, begin, end);
+    partial[OpenMP::getThreadNum()] = res;
+  }
+
+  Result res = init;
+  for (size_t i=0; i<nthreads; i++) { res = combine(res, partial[i]); }
+  return res;
+}
+
+
+/**
+ * Reduces the array @c A along @c axis into @c R (of the shape of @c A without @c axis), where
+ * @c R is initialized by the caller. @c line(x, n, inc) reduces a line of elements along
+ * @c axis, @c combine(a, b) combines two values.
+ *
+ * The loop follows the memory order of @c A, hence a column-sum of a row-major matrix adds
+ * rows element-wise and a row-sum reduces contiguous rows.
+ *
+ * @ingroup operators
+ */
+template <class Scalar, class Line, class Combine>
+inline void
+__reduce_axis(const Array<Scalar> &A, size_t axis, Array<Scalar> &R, Line line, Combine combine)
+{
+  // Strides of R with a zero stride along the axis:
+  Shape strides[2] = { A.strides(), Shape(A.ndim()) };
+  for (size_t d=0; d<A.ndim(); d++) {
+    strides[1][d] = (d < axis) ? R.strides(d) : ((d == axis) ? 0 : R.strides(d-1));
+  }
+
+  StridedLoop<2> loop(A.shape(), strides);
+  const Scalar *a0 = A.ptr(); Scalar *r0 = R.ptr();
+  size_t a_inc = loop.innerStride(0), r_inc = loop.innerStride(1);
+
+  // Serial, lines may share elements of R:
+  auto func = [&](const size_t *offsets, size_t n) {
+    const Scalar *a = a0 + offsets[0]; Scalar *r = r0 + offsets[1];
+    if (0 == r_inc) {
+      *r = combine(*r, line(a, n, a_inc));
+    } else if ((1 == r_inc) && (1 == a_inc)) {
+      for (size_t i=0; i<n; i++) { r[i] = combine(r[i], a[i]); }
+    } else {
+      for (size_t i=0; i<n; i++, a+=a_inc, r+=r_inc) { *r = combine(*r, *a); }
+    }
+  };
+  loop.run(func, 0, loop.size());
+}
+
+
+/**
+ * Returns the shape of @c A without @c axis.
+ *
+ * @throws ShapeError If @c A has less than 2 dimensions or @c axis is out of range.
+ */
+template <class Scalar>
+inline Shape __reduced_shape(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  LINALG_SHAPE_ASSERT((2 <= A.ndim()) && (axis < A.ndim()));
+  Shape shape(A.ndim()-1);
+  for (size_t d=0, j=0; d<A.ndim(); d++) {
+    if (d != axis) { shape[j++] = A.shape(d); }
+  }
+  return shape;
+}
+
+
+/**
+ * Returns the slice of @c A at index 0 along @c axis (a view).
+ */
+template <class Scalar>
+inline Array<Scalar> __first_slice(const Array<Scalar> &A, size_t axis)
+{
+  Shape strides(A.ndim()-1);
+  for (size_t d=0, j=0; d<A.ndim(); d++) {
+    if (d != axis) { strides[j++] = A.strides(d); }
+  }
+  return Array<Scalar>(A, A.offset(), __reduced_shape(A, axis), strides);
+}
+
+
+/**
+ * Returns the sum of all elements (0 for an empty array).
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar sum(const Array<Scalar> &A)
+{
+  StridedLoop<1> loop(A.shape(), &A.strides());
+  return __reduce(loop, A.ptr(), Scalar(0),
+                  [](const Scalar *x, size_t n, size_t inc, size_t) {
+                    return __sum_line(x, n, inc); }, __reduce_add());
+}
+
+
+/**
+ * Returns the mean of all elements.
+ *
+ * @throws ShapeError If the array is empty.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar mean(const Array<Scalar> &A) throw (ShapeError)
+{
+  LINALG_SHAPE_ASSERT((! A.shape().empty()) && (0 < A.shape().prod()));
+  return sum(A)/Scalar(A.shape().prod());
+}
+
+
+/**
+ * Returns the smallest element.
+ *
+ * @throws ShapeError If the array is empty.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar min(const Array<Scalar> &A) throw (ShapeError)
+{
+  StridedLoop<1> loop(A.shape(), &A.strides());
+  LINALG_SHAPE_ASSERT(0 < loop.size());
+  return __reduce(loop, A.ptr(), *A.ptr(),
+                  [](const Scalar *x, size_t n, size_t inc, size_t) {
+                    return __extremum_line<Scalar, false, false>(x, n, inc); },
+                  __reduce_extremum<false>());
+}
+
+
+/**
+ * Returns the largest element.
+ *
+ * @throws ShapeError If the array is empty.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar max(const Array<Scalar> &A) throw (ShapeError)
+{
+  StridedLoop<1> loop(A.shape(), &A.strides());
+  LINALG_SHAPE_ASSERT(0 < loop.size());
+  return __reduce(loop, A.ptr(), *A.ptr(),
+                  [](const Scalar *x, size_t n, size_t inc, size_t) {
+                    return __extremum_line<Scalar, true, false>(x, n, inc); },
+                  __reduce_extremum<true>());
+}
+
+
+/**
+ * Returns the largest absolute value of all elements (0 for an empty array) of a real array.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Scalar maxabs(const Array<Scalar> &A)
+{
+  StridedLoop<1> loop(A.shape(), &A.strides());
+  return __reduce(loop, A.ptr(), Scalar(0),
+                  [](const Scalar *x, size_t n, size_t inc, size_t) {
+                    return __extremum_line<Scalar, true, true>(x, n, inc); },
+                  __reduce_extremum<true>());
+}
+
+
+/**
+ * Returns the position of the smallest (@c MAX = false) or largest (@c MAX = true) element,
+ * where dimension 0 varies fastest (first position on ties).
+ */
+template <class Scalar, bool MAX>
+inline size_t __argextremum(const Array<Scalar> &A) throw (ShapeError)
+{
+  typedef std::pair<Scalar, size_t> Item;
+  StridedLoop<1> loop(A.shape(), &A.strides(), true);
+  LINALG_SHAPE_ASSERT(0 < loop.size());
+  Item res = __reduce(loop, A.ptr(), Item(*A.ptr(), 0),
+                      [](const Scalar *x, size_t n, size_t inc, size_t pos) {
+                        Item best(*x, pos);
+                        for (size_t i=1; i<n; i++) {
+                          x += inc;
+                          if (MAX ? (*x > best.first) : (*x < best.first)) {
+                            best.first = *x; best.second = pos+i;
+                          }
+                        }
+                        return best; },
+                      __reduce_argextremum<MAX>());
+  return res.second;
+}
+
+
+/**
+ * Returns the index of the smallest element (the first one, where dimension 0 varies fastest,
+ * if there are several).
+ *
+ * @throws ShapeError If the array is empty.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Shape argmin(const Array<Scalar> &A) throw (ShapeError)
+{
+  size_t pos = __argextremum<Scalar, false>(A);
+  Shape idx(A.ndim());
+  for (size_t d=0; d<A.ndim(); d++) { idx[d] = pos % A.shape(d); pos /= A.shape(d); }
+  return idx;
+}
+
+
+/**
+ * Returns the index of the largest element (the first one, where dimension 0 varies fastest,
+ * if there are several).
+ *
+ * @throws ShapeError If the array is empty.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Shape argmax(const Array<Scalar> &A) throw (ShapeError)
+{
+  size_t pos = __argextremum<Scalar, true>(A);
+  Shape idx(A.ndim());
+  for (size_t d=0; d<A.ndim(); d++) { idx[d] = pos % A.shape(d); pos /= A.shape(d); }
+  return idx;
+}
+
+
+/**
+ * Returns the index of the smallest element of a vector.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline size_t argmin(const Vector<Scalar> &x) throw (ShapeError)
+{
+  return __argextremum<Scalar, false>(x);
+}
+
+
+/**
+ * Returns the index of the largest element of a vector.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline size_t argmax(const Vector<Scalar> &x) throw (ShapeError)
+{
+  return __argextremum<Scalar, true>(x);
+}
+
+
+/**
+ * Returns the sums along the given axis, i.e. an array of the shape of @c A without @c axis.
+ * E.g. @c sum(A,0) of a matrix returns the column sums.
+ *
+ * @throws ShapeError If @c A has less than 2 dimensions or @c axis is out of range.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Array<Scalar> sum(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  Array<Scalar> R(__reduced_shape(A, axis), A.isRowMajor());
+  R.values() = Scalar(0);
+  __reduce_axis(A, axis, R, [](const Scalar *x, size_t n, size_t inc) {
+    return __sum_line(x, n, inc); }, __reduce_add());
+  return R;
+}
+
+
+/**
+ * Returns the means along the given axis, see @c sum.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Array<Scalar> mean(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  Array<Scalar> R = sum(A, axis);
+  R.values() = R/Scalar(A.shape(axis));
+  return R;
+}
+
+
+/**
+ * Returns the minima along the given axis, see @c sum.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Array<Scalar> min(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  Array<Scalar> R(__reduced_shape(A, axis), A.isRowMajor());
+  R.values() = __first_slice(A, axis);
+  __reduce_axis(A, axis, R, [](const Scalar *x, size_t n, size_t inc) {
+    return __extremum_line<Scalar, false, false>(x, n, inc); }, __reduce_extremum<false>());
+  return R;
+}
+
+
+/**
+ * Returns the maxima along the given axis, see @c sum.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Array<Scalar> max(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  Array<Scalar> R(__reduced_shape(A, axis), A.isRowMajor());
+  R.values() = __first_slice(A, axis);
+  __reduce_axis(A, axis, R, [](const Scalar *x, size_t n, size_t inc) {
+    return __extremum_line<Scalar, true, false>(x, n, inc); }, __reduce_extremum<true>());
+  return R;
+}
+
+
+/**
+ * Returns the largest absolute values along the given axis, see @c sum.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Array<Scalar> maxabs(const Array<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  Array<Scalar> R(__reduced_shape(A, axis), A.isRowMajor());
+  R.values() = Scalar(0);
+  __reduce_axis(A, axis, R, [](const Scalar *x, size_t n, size_t inc) {
+    return __extremum_line<Scalar, true, true>(x, n, inc); },
+    [](const Scalar &a, const Scalar &b) { return std::max(a, std::abs(b)); });
+  return R;
+}
+
+
+/**
+ * Returns the sums along the given axis of a matrix: @c sum(A,0) returns the column sums,
+ * @c sum(A,1) the row sums.
+ *
+ * @ingroup operators
+ */
+template <class Scalar>
+inline Vector<Scalar> sum(const Matrix<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  return Vector<Scalar>(sum(static_cast<const Array<Scalar> &>(A), axis));
+}
+
+/** Returns the means along the given axis of a matrix, see above. */
+template <class Scalar>
+inline Vector<Scalar> mean(const Matrix<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  return Vector<Scalar>(mean(static_cast<const Array<Scalar> &>(A), axis));
+}
+
+/** Returns the minima along the given axis of a matrix, see above. */
+template <class Scalar>
+inline Vector<Scalar> min(const Matrix<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  return Vector<Scalar>(min(static_cast<const Array<Scalar> &>(A), axis));
+}
+
+/** Returns the maxima along the given axis of a matrix, see above. */
+template <class Scalar>
+inline Vector<Scalar> max(const Matrix<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  return Vector<Scalar>(max(static_cast<const Array<Scalar> &>(A), axis));
+}
+
+/** Returns the largest absolute values along the given axis of a matrix, see above. */
+template <class Scalar>
+inline Vector<Scalar> maxabs(const Matrix<Scalar> &A, size_t axis) throw (ShapeError)
+{
+  return Vector<Scalar>(maxabs(static_cast<const Array<Scalar> &>(A), axis));
+}
+
+
+}
+
+#endif // __LINALG_REDUCE_HH__
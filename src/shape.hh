@@ -0,0 +1,198 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_SHAPE_HH__
+#define __LINALG_SHAPE_HH__
+
+#include "exception.hh"
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * Specifies the maximum number of dimensions of an @c Linalg::Array.
+ *
+ * @ingroup matrix
+ */
+#ifndef LINALG_MAX_NDIM
+#define LINALG_MAX_NDIM 8
+#endif
+
+
+namespace Linalg {
+
+/**
+ * A small, fixed-capacity vector of sizes, used to hold the shape, strides and indices of an
+ * @c Array.
+ *
+ * The elements are stored inline (up to @c LINALG_MAX_NDIM), hence creating, copying and
+ * indexing a shape never touches the heap. The interface resembles @c std::vector<size_t>.
+ *
+ * @ingroup matrix
+ */
+class Shape
+{
+public:
+  /** Iterator type. */
+  typedef size_t *iterator;
+  /** Const iterator type. */
+  typedef const size_t *const_iterator;
+
+protected:
+  /** Holds the number of elements. */
+  size_t _size;
+
+  /** Holds the elements. */
+  size_t _elements[LINALG_MAX_NDIM];
+
+
+public:
+  /**
+   * Constructs an empty shape.
+   */
+  Shape()
+    : _size(0)
+  {
+    // Pass...
+  }
+
+  /**
+   * Constructs a shape with @c n elements, all set to @c value.
+   */
+  explicit Shape(size_t n, size_t value=0)
+    : _size(0)
+  {
+    resize(n, value);
+  }
+
+  /**
+   * Constructs a shape from the given vector.
+   */
+  Shape(const std::vector<size_t> &vec)
+    : _size(0)
+  {
+    resize(vec.size());
+    for (size_t i=0; i<_size; i++) {
+      _elements[i] = vec[i];
+    }
+  }
+
+  /**
+   * Returns the number of elements.
+   */
+  inline size_t size() const {
+    return _size;
+  }
+
+  /**
+   * Returns true if the shape is empty.
+   */
+  inline bool empty() const {
+    return 0 == _size;
+  }
+
+  /**
+   * Resizes the shape to @c n elements, new elements are set to @c value.
+   *
+   * @throws ShapeError If @c n exceeds @c LINALG_MAX_NDIM.
+   */
+  inline void resize(size_t n, size_t value=0)
+  {
+    if (n > LINALG_MAX_NDIM) {
+      ShapeError err;
+      err << "Can not create array of dimension " << n
+          << ": At most " << LINALG_MAX_NDIM << " dimensions are supported.";
+      throw err;
+    }
+
+    for (size_t i=_size; i<n; i++) {
+      _elements[i] = value;
+    }
+    _size = n;
+  }
+
+  /**
+   * Appends an element.
+   */
+  inline void push_back(size_t value) {
+    resize(_size+1, value);
+  }
+
+  /**
+   * Removes all elements.
+   */
+  inline void clear() {
+    _size = 0;
+  }
+
+  /**
+   * Exchanges the content of two shapes.
+   */
+  inline void swap(Shape &other) {
+    Shape tmp(*this); *this = other; other = tmp;
+  }
+
+  inline size_t &operator[] (size_t i) { return _elements[i]; }
+  inline const size_t &operator[] (size_t i) const { return _elements[i]; }
+
+  inline size_t &back() { return _elements[_size-1]; }
+  inline const size_t &back() const { return _elements[_size-1]; }
+
+  inline iterator begin() { return _elements; }
+  inline iterator end() { return _elements + _size; }
+  inline const_iterator begin() const { return _elements; }
+  inline const_iterator end() const { return _elements + _size; }
+
+  /**
+   * Returns the product of all elements (the number of elements of an array with this shape).
+   */
+  inline size_t prod() const {
+    size_t p = 1;
+    for (size_t i=0; i<_size; i++) { p *= _elements[i]; }
+    return p;
+  }
+
+  /**
+   * Returns the shape in reversed order.
+   */
+  inline Shape reversed() const {
+    Shape r(_size);
+    for (size_t i=0; i<_size; i++) { r._elements[i] = _elements[_size-1-i]; }
+    return r;
+  }
+
+  /**
+   * Element-wise comparison.
+   */
+  inline bool operator== (const Shape &other) const {
+    if (_size != other._size) { return false; }
+    for (size_t i=0; i<_size; i++) {
+      if (_elements[i] != other._elements[i]) { return false; }
+    }
+    return true;
+  }
+
+  /**
+   * Element-wise comparison.
+   */
+  inline bool operator!= (const Shape &other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * Converts the shape into a @c std::vector.
+   */
+  inline std::vector<size_t> toVector() const {
+    return std::vector<size_t>(begin(), end());
+  }
+};
+
+
+}
+
+#endif // __LINALG_SHAPE_HH__
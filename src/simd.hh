@@ -9,52 +9,230 @@
 #ifndef __LINALG_SSE_HH__
 #define __LINALG_SSE_HH__
 
-namespace Linalg {
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include <complex>
+
 
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
 /**
- * Template prototype of all SMID traits.
+ * Is defined if the SIMD kernels are compiled for several instruction sets and selected at
+ * runtime, see @c SIMD.
  */
-template <class Scalar> class SIMDTraits;
+#define LINALG_SIMD_DISPATCH
+
+/** Compiles a function (and all functions inlined into it) for AVX2 and FMA. */
+#define LINALG_TARGET_AVX2 __attribute__((target("avx2,fma"), flatten))
+
+/** Compiles a function (and all functions inlined into it) for AVX-512F. */
+#define LINALG_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma"), flatten))
+#endif
 
 
+namespace Linalg {
+
 /**
- * SMID traits for double vectors.
+ * Implements the SIMD traits of a scalar type for vectors of @c Bytes bytes (16: SSE2/NEON,
+ * 32: AVX2, 64: AVX-512), using the vector extensions of the compiler. Vectors wider than the
+ * target architecture are emulated by the compiler, hence the wide traits should only be
+ * instantiated in functions compiled for the corresponding ISA (see @c LINALG_TARGET_AVX2).
  */
-template<>
-class SIMDTraits<double>
+template <class Scalar, size_t Bytes>
+class __SIMDTraits
 {
 public:
   /** Defines the elementary vector type for the scalar type. */
-  typedef double vector __attribute__( (vector_size(16), aligned(8)) );
+  typedef Scalar vector __attribute__( (vector_size(Bytes), aligned(sizeof(Scalar))) );
+
+  /** Defines the elementary vector type for the scalar type, with natural alignment. */
+  typedef Scalar avector __attribute__( (vector_size(Bytes)) );
+
+  /** Holds the number of elements in the vector/array. */
+  const static size_t num_elements = Bytes/sizeof(Scalar);
+
+  /** Holds the alignment (in bytes) required for aligned vector access. */
+  const static size_t alignment = Bytes;
 
   /** Defines an union, that allows for a direct element access. */
   typedef union {
     /** The elements as vector type for operations. */
     vector   v;
     /** The elements as array for element access. */
-    double   d[2];
+    Scalar   d[num_elements];
   } uvector;
 
-  /** Holds the number of elements in the vector/array. */
-  const static size_t num_elements = 2;
+  /** Defines an union for aligned vectors, that allows for a direct element access. */
+  typedef union {
+    /** The elements as vector type for operations. */
+    avector  v;
+    /** The elements as array for element access. */
+    Scalar   d[num_elements];
+  } auvector;
 };
 
 
+/**
+ * Template prototype of all SMID traits, @c Bytes specifies the vector width. The default
+ * width of 16 bytes is available on all supported architectures.
+ */
+template <class Scalar, size_t Bytes=16> class SIMDTraits;
+
+
+/**
+ * SMID traits for double vectors.
+ */
+template <size_t Bytes>
+class SIMDTraits<double, Bytes> : public __SIMDTraits<double, Bytes> { };
+
+
 /**
  * SMID traits for float vectors.
  */
-template<>
-class SIMDTraits<float>
+template <size_t Bytes>
+class SIMDTraits<float, Bytes> : public __SIMDTraits<float, Bytes> { };
+
+
+/**
+ * SIMD traits for complex vectors: As complex numbers are stored as pairs of their real and
+ * imaginary parts, the SIMD vectors of the real type hold @c num_elements/2 interleaved complex
+ * numbers. The complex kernels operate on these vectors, see @c __simd_swap_pairs.
+ */
+template <class Real, size_t Bytes>
+class SIMDTraits<std::complex<Real>, Bytes> : public SIMDTraits<Real, Bytes> { };
+
+
+/**
+ * Is @c std::true_type if @c SIMDTraits are defined for the scalar type, @c std::false_type
+ * otherwise. Allows to dispatch between SIMD and generic implementations at compile time.
+ */
+template <class Scalar> struct __has_simd : public std::false_type { };
+template <> struct __has_simd<double> : public std::true_type { };
+template <> struct __has_simd<float> : public std::true_type { };
+
+
+/**
+ * Returns true if the given pointer is suitable for aligned SIMD vector access (with vectors of
+ * @c Bytes bytes).
+ */
+template <class Scalar, size_t Bytes=16>
+inline bool __is_simd_aligned(const Scalar *ptr)
+{
+  return 0 == (reinterpret_cast<size_t>(ptr) % SIMDTraits<Scalar, Bytes>::alignment);
+}
+
+
+/**
+ * Returns the number of leading elements (at most @c N) to process before @c ptr is suitable
+ * for aligned SIMD vector access (with vectors of @c Bytes bytes), i.e. the length of the
+ * prologue of a kernel. Returns 0 if @c ptr is not even aligned to the scalar type, such a
+ * pointer can not be aligned by peeling.
+ */
+template <class Scalar, size_t Bytes=16>
+inline size_t __simd_peel(const Scalar *ptr, size_t N)
+{
+  size_t addr = reinterpret_cast<size_t>(ptr);
+  if (0 != (addr % sizeof(Scalar))) { return 0; }
+  return std::min(N, ((Bytes - addr % Bytes) % Bytes)/sizeof(Scalar));
+}
+
+
+/**
+ * Swaps the neighbouring elements (0,1), (2,3), ... of a SIMD vector union, i.e. the real and
+ * imaginary parts of interleaved complex numbers. Compilers turn the (fully unrolled) loop into
+ * a single shuffle instruction.
+ */
+template <class VecType>
+inline VecType __simd_swap_pairs(const VecType &x)
+{
+  VecType res;
+  const size_t N_elm = sizeof(x.d)/sizeof(x.d[0]);
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 16
+#endif
+  for (size_t i=0; i<N_elm; i++) {
+    res.d[i] = x.d[i^1];
+  }
+  return res;
+}
+
+
+/**
+ * Selects the instruction set of the SIMD kernels of the library at runtime.
+ *
+ * The dense BLAS level 1 kernels (@c dot, @c dotc, @c axpy, @c scal and @c nrm2, for real and
+ * complex vectors) are compiled for several instruction sets, using 16 (@c BASE, i.e. SSE2), 32 (@c AVX2, with FMA) and 64 byte
+ * (@c AVX512) vectors. The best level supported by the CPU is determined once, on first use.
+ * The environment variable @c LINALG_SIMD (one of @c base, @c avx2 or @c avx512) lowers the
+ * level, e.g. for A/B benchmarks; levels not supported by the CPU are ignored.
+ *
+ * The dispatch requires GCC or Clang on x86 (@c LINALG_SIMD_DISPATCH is defined then), on
+ * other platforms the @c BASE kernels are used.
+ */
+class SIMD
 {
 public:
-  typedef float vector __attribute__ ( (vector_size(16), aligned(4)) );
+  /** The instruction set levels. */
+  typedef enum {
+    BASE = 0,     ///< 16-byte vectors (SSE2 on x86).
+    AVX2 = 1,     ///< 32-byte vectors (AVX2 and FMA).
+    AVX512 = 2    ///< 64-byte vectors (AVX-512F).
+  } Level;
 
-  typedef union {
-    vector   v;
-    float    d[4];
-  } uvector;
+  /** Returns the best level supported by the CPU. */
+  static inline Level supported() {
+#ifdef LINALG_SIMD_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return AVX512; }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return AVX2; }
+#endif
+    return BASE;
+  }
+
+  /** Returns the level used by the kernels. */
+  static inline Level level() {
+    return Level(current().load(std::memory_order_relaxed));
+  }
+
+  /**
+   * Sets the level used by the kernels, limited to the supported level. Returns the level set.
+   */
+  static inline Level setLevel(Level level) {
+    level = std::min(level, supported());
+    current().store(level, std::memory_order_relaxed);
+    return level;
+  }
+
+  /** Returns the name of the given level. */
+  static inline const char *name(Level level) {
+    switch (level) {
+    case AVX512: return "avx512";
+    case AVX2: return "avx2";
+    default: break;
+    }
+    return "base";
+  }
+
+protected:
+  /** Returns the level given by the environment variable @c LINALG_SIMD, or the supported. */
+  static inline Level initial() {
+    Level level = supported();
+    const char *env = std::getenv("LINALG_SIMD");
+    if (0 == env) { return level; }
+    for (int l=BASE; l<=AVX512; l++) {
+      if (0 == std::strcmp(env, name(Level(l)))) { return std::min(level, Level(l)); }
+    }
+    return level;
+  }
 
-  const static size_t num_elements = 4;
+  /** Holds the current level, initialized on first use. */
+  static inline std::atomic<int> &current() {
+    static std::atomic<int> level(initial());
+    return level;
+  }
 };
 
 
@@ -0,0 +1,501 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_STREAM_HH__
+#define __LINALG_STREAM_HH__
+
+#include "io.hh"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <cstring>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace Linalg {
+
+/**
+ * Reads exactly @c bytes from the given file descriptor, returns false on error or EOF.
+ *
+ * @ingroup io
+ */
+inline bool __read_fully(int fd, void *buffer, size_t bytes)
+{
+  char *ptr = reinterpret_cast<char *>(buffer);
+  while (0 < bytes) {
+    ssize_t n = ::read(fd, ptr, bytes);
+    if ((0 > n) && (EINTR == errno)) { continue; }
+    if (0 >= n) { return false; }
+    ptr += n; bytes -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Writes exactly @c bytes to the given file descriptor, returns false on error.
+ *
+ * @ingroup io
+ */
+inline bool __write_fully(int fd, const void *buffer, size_t bytes)
+{
+  const char *ptr = reinterpret_cast<const char *>(buffer);
+  while (0 < bytes) {
+    ssize_t n = ::write(fd, ptr, bytes);
+    if ((0 > n) && (EINTR == errno)) { continue; }
+    if (0 >= n) { return false; }
+    ptr += n; bytes -= n;
+  }
+  return true;
+}
+
+
+/**
+ * Skips @c bytes of the given file descriptor. Seeks if possible, reads otherwise (pipes).
+ *
+ * @ingroup io
+ */
+inline bool __skip(int fd, size_t bytes)
+{
+  if (0 <= lseek(fd, bytes, SEEK_CUR)) {
+    return true;
+  }
+
+  char buffer[4096];
+  while (0 < bytes) {
+    size_t n = std::min(bytes, sizeof(buffer));
+    if (! __read_fully(fd, buffer, n)) { return false; }
+    bytes -= n;
+  }
+  return true;
+}
+
+
+
+/**
+ * Reads a matrix record of a binary container file (see @c BinaryWriter) panel by panel.
+ *
+ * A row-major record is delivered as panels of (at most) @c panel rows, a column-major record
+ * as panels of (at most) @c panel columns, i.e. each panel is a contiguous chunk of the file.
+ * The reader uses two panel buffers: While the consumer processes one panel, the next one is
+ * read in the background by a worker thread, that is started with the first prefetch and lives
+ * as long as the reader (double-buffered prefetch). Hence the memory needed is bounded by two
+ * panels, independent of the size of the matrix. The input may be a file or a pipe.
+ *
+ * @code
+ * PanelReader<double> reader("X.bin", 1024);
+ * Matrix<double> P;
+ * while (reader.next(P)) {
+ *   // P holds rows reader.offset() ... reader.offset()+P.rows()-1 of X
+ * }
+ * @endcode
+ *
+ * @ingroup io
+ */
+template <class Scalar>
+class PanelReader
+{
+protected:
+  /** The file descriptor. */
+  int _fd;
+  /** If true, the file descriptor is closed by the reader. */
+  bool _owns_fd;
+  /** The header of the record. */
+  BinaryHeader _header;
+  /** The number of rows (row-major) or columns (column-major) per panel. */
+  size_t _panel;
+  /** The total number of rows (row-major) or columns (column-major). */
+  size_t _outer;
+  /** The number of elements of each row (row-major) or column (column-major). */
+  size_t _inner;
+  /** The panel buffers. */
+  Matrix<Scalar> _buffers[2];
+  /** The index of the buffer delivered last. */
+  size_t _current;
+  /** The number of rows/columns read from the stream. */
+  size_t _read;
+  /** The offset of the last delivered panel. */
+  size_t _offset;
+  /** The prefetch worker thread. */
+  std::thread _worker;
+  /** Protects the prefetch request and result below. */
+  std::mutex _mutex;
+  /** Signals a new request to the worker and its completion to the reader. */
+  std::condition_variable _cond;
+  /** The number of rows/columns requested from the worker, 0 if idle. */
+  size_t _request;
+  /** If true, a prefetch was requested and its result was not yet collected. */
+  bool _pending;
+  /** Tells the worker to exit. */
+  bool _stop;
+  /** The number of rows/columns read by the last prefetch. */
+  size_t _prefetched;
+  /** Is set by the prefetch on error. */
+  bool _error;
+
+
+public:
+  /**
+   * Opens the given file and seeks to the @c record-th record.
+   *
+   * @throws IOError If the file can not be opened or does not contain such a matrix record.
+   * @throws ShapeError If @c panel is 0.
+   */
+  PanelReader(const std::string &filename, size_t panel, size_t record=0)
+  throw (IOError, ShapeError)
+    : _fd(::open(filename.c_str(), O_RDONLY)), _owns_fd(true), _panel(panel)
+  {
+    if (0 > _fd) {
+      IOError err;
+      err << "Can not open file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+    init(record);
+  }
+
+  /**
+   * Reads from the given file descriptor (e.g. a pipe). The descriptor is not closed by the
+   * reader.
+   *
+   * @throws IOError If the stream does not contain such a matrix record.
+   * @throws ShapeError If @c panel is 0.
+   */
+  PanelReader(int fd, size_t panel, size_t record=0) throw (IOError, ShapeError)
+    : _fd(fd), _owns_fd(false), _panel(panel)
+  {
+    init(record);
+  }
+
+  /**
+   * Waits for a pending prefetch, stops the worker and closes the file.
+   */
+  ~PanelReader() {
+    if (_worker.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+      }
+      _cond.notify_all();
+      _worker.join();
+    }
+    if (_owns_fd) { ::close(_fd); }
+  }
+
+  /** Returns the number of rows of the matrix. */
+  inline size_t rows() const { return _header.shape[0]; }
+  /** Returns the number of columns of the matrix. */
+  inline size_t cols() const { return (1 == _header.ndim) ? 1 : _header.shape[1]; }
+  /** Returns true if the panels are rows (row-major record), false if they are columns. */
+  inline bool rowPanels() const { return 0 != (_header.flags & BinaryHeader::ROW_MAJOR); }
+  /** Returns the index of the first row (or column) of the last panel. */
+  inline size_t offset() const { return _offset; }
+
+  /**
+   * Assigns the next panel to @c P and returns true, returns false if all panels were read. Once
+   * all panels were read, subsequent calls return false without touching the stream. The panel
+   * refers to an internal buffer, that stays valid until the next call.
+   *
+   * @throws IOError If the stream ends prematurely.
+   */
+  bool next(Matrix<Scalar> &P) throw (IOError)
+  {
+    size_t n = 0;
+    if (_pending) {
+      n = wait();
+      _current = 1-_current; _offset = _read; _read += n;
+    } else if ((0 == _read) && (0 < _outer) && (! _error)) {
+      // First panel, read synchronously:
+      n = fill(_current, std::min(_panel, _outer));
+      _offset = 0; _read = n;
+    }
+
+    if (_error) {
+      IOError err;
+      err << "Unexpected end of stream after " << _read << " of " << _outer
+          << (rowPanels() ? " rows." : " columns.");
+      throw err;
+    }
+
+    if (0 == n) {
+      P = Matrix<Scalar>();
+      return false;
+    }
+
+    // Start prefetching the next panel into the other buffer:
+    size_t m = std::min(_panel, _outer-_read);
+    if (0 < m) {
+      request(m);
+    }
+
+    if (rowPanels()) {
+      P = _buffers[_current].sub(0,0, n,_inner);
+    } else {
+      P = _buffers[_current].sub(0,0, _inner,n);
+    }
+    return true;
+  }
+
+
+protected:
+  /** Reads the header and allocates the buffers. */
+  void init(size_t record) throw (IOError, ShapeError)
+  {
+    _current = 0; _read = 0; _offset = 0;
+    _request = 0; _pending = false; _stop = false; _prefetched = 0; _error = false;
+
+    if (0 == _panel) {
+      if (_owns_fd) { ::close(_fd); }
+      ShapeError err; err << "Can not read panels of 0 rows/columns.";
+      throw err;
+    }
+
+    for (size_t i=0; i<=record; i++) {
+      if ((! __read_fully(_fd, &_header, sizeof(BinaryHeader))) || (! _header.isValid())) {
+        if (_owns_fd) { ::close(_fd); }
+        IOError err; err << "Can not read record " << i << ": Invalid or missing header.";
+        throw err;
+      }
+      if ((i < record) && (! __skip(_fd, _header.payloadSize()))) {
+        if (_owns_fd) { ::close(_fd); }
+        IOError err; err << "Can not skip record " << i << ".";
+        throw err;
+      }
+    }
+
+    if ((__binary_dtype<Scalar>::code != _header.dtype) ||
+        (sizeof(Scalar) != _header.element_size)) {
+      if (_owns_fd) { ::close(_fd); }
+      IOError err; err << "Can not read record " << record << ": Type mismatch.";
+      throw err;
+    }
+
+    if (rowPanels()) {
+      _outer = rows(); _inner = cols();
+      _buffers[0] = Matrix<Scalar>(_panel, _inner, true);
+      _buffers[1] = Matrix<Scalar>(_panel, _inner, true);
+    } else {
+      _outer = cols(); _inner = rows();
+      _buffers[0] = Matrix<Scalar>(_inner, _panel, false);
+      _buffers[1] = Matrix<Scalar>(_inner, _panel, false);
+    }
+  }
+
+  /** Reads @c n rows/columns into the given buffer, returns the number read. */
+  size_t fill(size_t buffer, size_t n)
+  {
+    if (! __read_fully(_fd, _buffers[buffer].ptr(), n*_inner*sizeof(Scalar))) {
+      _error = true; return 0;
+    }
+
+    // Skip padding after the last panel:
+    if (_read + n == _outer) {
+      __skip(_fd, _header.payloadSize() - _header.size()*sizeof(Scalar));
+    }
+    return n;
+  }
+
+  /** Requests the worker to read the next @c n rows/columns into the other buffer. */
+  void request(size_t n)
+  {
+    if (! _worker.joinable()) {
+      _worker = std::thread(&PanelReader<Scalar>::work, this);
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _request = n; _pending = true;
+    }
+    _cond.notify_all();
+  }
+
+  /** Waits for the pending prefetch and returns the number of rows/columns read. */
+  size_t wait()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (0 < _request) { _cond.wait(lock); }
+    _pending = false;
+    return _prefetched;
+  }
+
+  /** Entry point of the worker thread, serves the prefetch requests until stopped. */
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+      while ((! _stop) && (0 == _request)) { _cond.wait(lock); }
+      if (_stop) { return; }
+      size_t buffer = 1-_current, n = _request;
+      lock.unlock();
+      size_t m = fill(buffer, n);
+      lock.lock();
+      _prefetched = m; _request = 0;
+      _cond.notify_all();
+    }
+  }
+};
+
+
+
+/**
+ * Writes a matrix record of a binary container file panel by panel.
+ *
+ * The shape of the matrix has to be known in advance. Panels are rows (row-major) or columns
+ * (column-major) of the matrix and must be written in order. The output may be a file or a pipe.
+ * Call @c close to check that the record is complete. Panels, whose layout differs from the
+ * storage order of the record, are copied into a contiguous panel first, such that each panel
+ * is written by a single call.
+ *
+ * @ingroup io
+ */
+template <class Scalar>
+class PanelWriter
+{
+protected:
+  /** The file descriptor. */
+  int _fd;
+  /** If true, the file descriptor is closed by the writer. */
+  bool _owns_fd;
+  /** The header of the record. */
+  BinaryHeader _header;
+  /** The total number of rows (row-major) or columns (column-major). */
+  size_t _outer;
+  /** The number of elements of each row (row-major) or column (column-major). */
+  size_t _inner;
+  /** The number of rows/columns written. */
+  size_t _written;
+  /** Is set if a write failed. */
+  bool _error;
+
+
+public:
+  /**
+   * Creates the given file and writes the header of a @c rows x @c cols matrix.
+   *
+   * @throws IOError If the file can not be created.
+   */
+  PanelWriter(const std::string &filename, size_t rows, size_t cols, bool rowmajor=true)
+  throw (IOError)
+    : _fd(::open(filename.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644)), _owns_fd(true)
+  {
+    if (0 > _fd) {
+      IOError err;
+      err << "Can not create file " << filename << ": " << strerror(errno);
+      throw err;
+    }
+    init(rows, cols, rowmajor);
+  }
+
+  /**
+   * Writes the header of a @c rows x @c cols matrix to the given file descriptor (e.g. a pipe).
+   * The descriptor is not closed by the writer.
+   *
+   * @throws IOError If the header can not be written.
+   */
+  PanelWriter(int fd, size_t rows, size_t cols, bool rowmajor=true) throw (IOError)
+    : _fd(fd), _owns_fd(false)
+  {
+    init(rows, cols, rowmajor);
+  }
+
+  /** Closes the file (use @c close to check that the record is complete). */
+  ~PanelWriter() {
+    if (_owns_fd && (0 <= _fd)) { ::close(_fd); }
+  }
+
+  /**
+   * Closes the file (if owned by the writer).
+   *
+   * @throws IOError If not all rows/columns of the matrix were written or a write failed.
+   */
+  void close() throw (IOError)
+  {
+    if (0 > _fd) { return; }
+    if (_owns_fd) { ::close(_fd); }
+    _fd = -1;
+    if (_error || (_written < _outer)) {
+      IOError err;
+      err << "Incomplete record, only " << _written << " of " << _outer
+          << " rows/columns written" << (_error ? " (write failed)." : ".");
+      throw err;
+    }
+  }
+
+  /** Returns the number of rows/columns written so far. */
+  inline size_t written() const { return _written; }
+
+  /**
+   * Appends the rows (row-major) or columns (column-major) of the given panel.
+   *
+   * @throws ShapeError If the panel does not match the matrix.
+   * @throws IOError If the panel can not be written.
+   */
+  void write(const Matrix<Scalar> &P) throw (IOError, ShapeError)
+  {
+    if (0 > _fd) {
+      IOError err; err << "Can not write panel: Writer is closed.";
+      throw err;
+    }
+    bool rowmajor = 0 != (_header.flags & BinaryHeader::ROW_MAJOR);
+    size_t n = rowmajor ? P.rows() : P.cols();
+    LINALG_SHAPE_ASSERT(_inner == (rowmajor ? P.cols() : P.rows()));
+    LINALG_SHAPE_ASSERT(_written + n <= _outer);
+
+    bool ok = true;
+    if ((1 == P.strides(rowmajor ? 1 : 0)) && (_inner == P.strides(rowmajor ? 0 : 1))) {
+      ok = __write_fully(_fd, P.ptr(), n*_inner*sizeof(Scalar));
+    } else {
+      // Copy into a contiguous panel in the storage order of the record:
+      Matrix<Scalar> C(P.rows(), P.cols(), rowmajor);
+      C.values() = P;
+      ok = __write_fully(_fd, C.ptr(), n*_inner*sizeof(Scalar));
+    }
+
+    if (! ok) {
+      _error = true;
+      IOError err; err << "Can not write panel: " << strerror(errno);
+      throw err;
+    }
+
+    _written += n;
+    if (_written == _outer) {
+      // Write padding after the last panel:
+      static const char zeros[BinaryHeader::alignment] = {0};
+      if (! __write_fully(_fd, zeros, _header.payloadSize() - _header.size()*sizeof(Scalar))) {
+        _error = true;
+        IOError err; err << "Can not write padding: " << strerror(errno);
+        throw err;
+      }
+    }
+  }
+
+
+protected:
+  /** Writes the header. */
+  void init(size_t rows, size_t cols, bool rowmajor) throw (IOError)
+  {
+    _header = BinaryHeader::create<Scalar>(2, rowmajor ? BinaryHeader::ROW_MAJOR : 0);
+    _header.shape[0] = rows; _header.shape[1] = cols;
+    _header.strides[0] = rowmajor ? cols : 1; _header.strides[1] = rowmajor ? 1 : rows;
+    _outer = rowmajor ? rows : cols; _inner = rowmajor ? cols : rows; _written = 0;
+    _error = false;
+
+    if (! __write_fully(_fd, &_header, sizeof(BinaryHeader))) {
+      if (_owns_fd) { ::close(_fd); _fd = -1; }
+      IOError err; err << "Can not write header: " << strerror(errno);
+      throw err;
+    }
+  }
+};
+
+
+}
+
+#endif // __LINALG_STREAM_HH__
@@ -40,12 +40,25 @@ public:
    */
   SymMatrix(const SymMatrix<Scalar> &other) : TriMatrix<Scalar>(other) { }
 
+  /**
+   * Move constructor.
+   */
+  SymMatrix(SymMatrix<Scalar> &&other) noexcept : TriMatrix<Scalar>(std::move(other)) { }
+
+  SymMatrix(TriMatrix<Scalar> &&other) noexcept : TriMatrix<Scalar>(std::move(other)) { }
+
   inline SymMatrix<Scalar> &operator= (const SymMatrix &other)
   {
     TriMatrix<Scalar>::operator =(other);
     return *this;
   }
 
+  inline SymMatrix<Scalar> &operator= (SymMatrix &&other) noexcept
+  {
+    TriMatrix<Scalar>::operator =(std::move(other));
+    return *this;
+  }
+
   inline SymMatrix<Scalar> t() const {
     return TriMatrix<Scalar>::t();
   }
@@ -55,6 +55,17 @@ public:
   }
 
 
+  /**
+   * Move constructor, leaves @c other as an empty matrix.
+   */
+  TriMatrix(TriMatrix<Scalar> &&other) noexcept
+    : Matrix<Scalar>(std::move(other)),
+      _is_upper(other._is_upper), _is_unit_triangular(other._is_unit_triangular)
+  {
+    // Pass...
+  }
+
+
   /**
    * Assignment operation.
    */
@@ -69,6 +80,30 @@ public:
   }
 
 
+  /**
+   * Move assignment, leaves @c other as an empty matrix.
+   */
+  TriMatrix<Scalar> &operator= (TriMatrix<Scalar> &&other) noexcept
+  {
+    static_cast< Matrix<Scalar> &>(*this) = std::move(other);
+    this->_is_upper = other._is_upper;
+    this->_is_unit_triangular = other._is_unit_triangular;
+
+    return *this;
+  }
+
+
+  /**
+   * Exchanges the data, shape and flags of this matrix and @c other.
+   */
+  inline void swap(TriMatrix<Scalar> &other) noexcept
+  {
+    Matrix<Scalar>::swap(other);
+    std::swap(this->_is_upper, other._is_upper);
+    std::swap(this->_is_unit_triangular, other._is_unit_triangular);
+  }
+
+
   Scalar operator() (size_t i, size_t j)
   {
     return Matrix<Scalar>::operator ()(i,j);
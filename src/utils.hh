@@ -35,6 +35,38 @@ __prod_abcc(const std::complex<double> &a, const std::complex<double> &b)
                               a.imag()*b.real() - a.real()*b.imag());
 }
 
+/**
+ * Utility function to unify the BLAS level 1 codes, calculates a*b^* for single precision.
+ */
+inline float
+__prod_abcc(const float &a, const float &b)
+{
+  return a*b;
+}
+
+/**
+ * Utility function to unify the BLAS level 1 codes, calculates a*b^* for single precision.
+ */
+inline std::complex<float>
+__prod_abcc(const std::complex<float> &a, const std::complex<float> &b)
+{
+  return std::complex<float>(a.real()*b.real() + a.imag()*b.imag(),
+                             a.imag()*b.real() - a.real()*b.imag());
+}
+
+/**
+ * Utility function to calculate the complex product a*b directly. In contrast to the operator
+ * of @c std::complex, no NaN/inf recovery is performed (which is a library call unless
+ * compiled with -ffast-math).
+ */
+template <class Real>
+inline std::complex<Real>
+__prod_ab(const std::complex<Real> &a, const std::complex<Real> &b)
+{
+  return std::complex<Real>(a.real()*b.real() - a.imag()*b.imag(),
+                            a.real()*b.imag() + a.imag()*b.real());
+}
+
 /**
  * Utility function to calculate either a*a if a is real or a*a^* if a is complex.
  */
@@ -3,6 +3,7 @@
 
 #include "array.hh"
 #include "exception.hh"
+#include "random.hh"
 
 
 namespace Linalg {
@@ -22,7 +23,7 @@ protected:
    */
   Vector(Scalar *data, size_t offset, size_t dim, size_t incr, bool takes_ownership=true)
     : Array<Scalar>(DataPtr<Scalar>(new DataMngr<Scalar>(data, takes_ownership)),
-        offset, std::vector<size_t>(1, dim), std::vector<size_t>(1, incr))
+        offset, Shape(1, dim), Shape(1, incr))
   {
     // Pass...
   }
@@ -33,7 +34,7 @@ public:
    * Assembles a complete vector from given memory.
    */
   Vector(const DataPtr<Scalar> &data, size_t offset, size_t dim, size_t incr)
-    : Array<Scalar>(data, offset, std::vector<size_t>(1, dim), std::vector<size_t>(1, incr))
+    : Array<Scalar>(data, offset, Shape(1, dim), Shape(1, incr))
   {
     // Pass...
   }
@@ -49,11 +50,14 @@ public:
   }
 
 
+  /**
+   * Allocates an uninitialized vector of given size, aligned to @c LINALG_ALIGNMENT.
+   */
   Vector(size_t dim)
-    : Array<Scalar>()
+    : Array<Scalar>(DataPtr<Scalar>(DataMngr<Scalar>::allocate(dim)),
+                    0, Shape(1, dim), Shape(1, 1))
   {
-    Scalar *data = new Scalar[dim];
-    *this = Vector<Scalar>(data, 0, dim, 1, true);
+    NUMA::place(this->_mngr->ptr(), dim*sizeof(Scalar));
   }
 
 
@@ -66,6 +70,15 @@ public:
     // Pass...
   }
 
+  /**
+   * Move constructor, leaves @c other as an empty vector.
+   */
+  Vector(Vector &&other) noexcept
+    : Array<Scalar>(std::move(other))
+  {
+    // Pass...
+  }
+
   /**
    * Copy constructor from array.
    */
@@ -75,6 +88,25 @@ public:
     LINALG_SHAPE_ASSERT(1 == other.ndim());
   }
 
+  /**
+   * Allocates a new vector and evaluates the given element-wise expression into it.
+   */
+  template <class Expr>
+  Vector(const ArrayExpr<Expr> &expr)
+    : Array<Scalar>(expr)
+  {
+    LINALG_SHAPE_ASSERT(1 == this->ndim());
+  }
+
+  /**
+   * Move constructor from a 1D array.
+   */
+  explicit Vector(Array<Scalar> &&other)
+    : Array<Scalar>(std::move(other))
+  {
+    LINALG_SHAPE_ASSERT(1 == this->ndim());
+  }
+
   /**
    * Copy constructor, also copies the memory.
    */
@@ -93,6 +125,23 @@ public:
     return *this;
   }
 
+  /**
+   * Move assignment, leaves @c other as an empty vector.
+   */
+  inline Vector<Scalar> &operator= (Vector<Scalar> &&other) noexcept
+  {
+    Array<Scalar>::operator= (std::move(other));
+    return *this;
+  }
+
+  /**
+   * Exchanges the data and shape of this vector and @c other.
+   */
+  inline void swap(Vector<Scalar> &other) noexcept
+  {
+    Array<Scalar>::swap(other);
+  }
+
 
   /**
    * Returns the dimension of the vector.
@@ -150,20 +199,70 @@ public:
 
 public:
   /**
-   * Allocates an uninitialized vector of given size.
+   * Allocates an uninitialized vector of given size, aligned to @c LINALG_ALIGNMENT.
    */
   static Vector<Scalar> empty(size_t dim)
   {
-    Scalar *data = new Scalar[dim];
-    return Vector(data, 0, dim, 1, true);
+    return Vector<Scalar>(dim);
   }
 
 
+  /**
+   * Returns a vector initialized with all values = 0, first-touched according to the NUMA
+   * policy.
+   */
   static Vector<Scalar> zero(size_t dim)
   {
     Vector<Scalar> vec = empty(dim);
-    for (size_t i=0; i<dim; i++)
-      vec(i) = 0;
+    __first_touch(vec.ptr(), dim, 1, 1, Scalar(0));
+    return vec;
+  }
+
+
+  /**
+   * Constructs a new vector initialized with [0,1) uniform distributed random numbers of the
+   * next stream of the global seed (see @c Random).
+   */
+  static Vector<Scalar> rand(size_t dim)
+  {
+    return random(dim, Random::next(), false);
+  }
+
+  /**
+   * Constructs a new vector initialized with [0,1) uniform distributed random numbers of the
+   * given seed. The values are reproducible, independent of the number of threads.
+   */
+  static Vector<Scalar> rand(size_t dim, uint64_t seed)
+  {
+    return random(dim, Philox(seed), false);
+  }
+
+  /**
+   * Constructs a new vector initialized with standard normal distributed random numbers of the
+   * next stream of the global seed (see @c Random).
+   */
+  static Vector<Scalar> randn(size_t dim)
+  {
+    return random(dim, Random::next(), true);
+  }
+
+  /**
+   * Constructs a new vector initialized with standard normal distributed random numbers of the
+   * given seed.
+   */
+  static Vector<Scalar> randn(size_t dim, uint64_t seed)
+  {
+    return random(dim, Philox(seed), true);
+  }
+
+  /**
+   * Constructs a new vector initialized with uniform or normal distributed random numbers of
+   * the given generator, see @c __random_fill.
+   */
+  static Vector<Scalar> random(size_t dim, const Philox &gen, bool normal)
+  {
+    Vector<Scalar> vec = empty(dim);
+    __random_fill(vec.ptr(), 1, dim, 0, vec.stride(), gen, normal);
     return vec;
   }
 };
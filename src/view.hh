@@ -0,0 +1,220 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef __LINALG_VIEW_HH__
+#define __LINALG_VIEW_HH__
+
+#include "vector.hh"
+#include "matrix.hh"
+
+
+namespace Linalg {
+
+/**
+ * A lightweight, non-owning view to a strided vector.
+ *
+ * In contrast to @c Vector, a view holds just a pointer, the dimension and the stride. It does
+ * not hold a reference to the data, hence creating and copying a view never touches the
+ * reference counter or the heap. The caller has to ensure, that the viewed data outlives the
+ * view. Views are intended for the inner loops of BLAS and LAPACK routines.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+class VectorView
+{
+protected:
+  /** Pointer to the first element. */
+  Scalar *_ptr;
+  /** The dimension of the vector. */
+  size_t _dim;
+  /** The increment between consecutive elements. */
+  size_t _stride;
+
+public:
+  /** Constructs an empty view. */
+  VectorView()
+    : _ptr(0), _dim(0), _stride(1)
+  {
+    // Pass...
+  }
+
+  /** Constructs a view to the given data. */
+  VectorView(Scalar *ptr, size_t dim, size_t stride)
+    : _ptr(ptr), _dim(dim), _stride(stride)
+  {
+    // Pass...
+  }
+
+  /**
+   * Constructs a view to the elements of the given vector. The view allows to modify the
+   * elements, hence it can not be constructed from a const vector (see @c __readonly_view).
+   */
+  VectorView(Vector<Scalar> &vec)
+    : _ptr(vec.ptr()), _dim(vec.dim()), _stride(vec.stride())
+  {
+    // Pass...
+  }
+
+  /** Constructs a view to the elements of the given (temporary) vector. */
+  VectorView(Vector<Scalar> &&vec)
+    : _ptr(vec.ptr()), _dim(vec.dim()), _stride(vec.stride())
+  {
+    // Pass...
+  }
+
+  /** Returns the dimension of the vector. */
+  inline size_t dim() const { return _dim; }
+  /** Returns the increment between consecutive elements. */
+  inline size_t stride() const { return _stride; }
+  /** Returns the increment between consecutive elements, @c i must be 0. */
+  inline size_t strides(size_t i) const { return _stride; }
+  /** Returns the pointer to the first element. */
+  inline Scalar *ptr() const { return _ptr; }
+
+  /** Returns a reference to the i-th element. */
+  inline Scalar &operator() (size_t i) const {
+    return _ptr[i*_stride];
+  }
+
+  /** Returns a view to the sub-vector of @c n elements starting at @c i. */
+  inline VectorView<Scalar> sub(size_t i, size_t n) const {
+    return VectorView<Scalar>(_ptr + i*_stride, n, _stride);
+  }
+};
+
+
+
+/**
+ * A lightweight, non-owning view to a strided matrix.
+ *
+ * Like @c VectorView, this class holds just a pointer, the shape and the strides of a matrix and
+ * does not hold a reference to the data.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+class MatrixView
+{
+protected:
+  /** Pointer to the first element. */
+  Scalar *_ptr;
+  /** The number of rows. */
+  size_t _rows;
+  /** The number of columns. */
+  size_t _cols;
+  /** The increment between consecutive rows. */
+  size_t _row_stride;
+  /** The increment between consecutive columns. */
+  size_t _col_stride;
+
+public:
+  /** Constructs an empty view. */
+  MatrixView()
+    : _ptr(0), _rows(0), _cols(0), _row_stride(0), _col_stride(1)
+  {
+    // Pass...
+  }
+
+  /** Constructs a view to the given data. */
+  MatrixView(Scalar *ptr, size_t rows, size_t cols, size_t row_stride, size_t col_stride)
+    : _ptr(ptr), _rows(rows), _cols(cols), _row_stride(row_stride), _col_stride(col_stride)
+  {
+    // Pass...
+  }
+
+  /**
+   * Constructs a view to the elements of the given matrix. The view allows to modify the
+   * elements, hence it can not be constructed from a const matrix (see @c __readonly_view).
+   */
+  MatrixView(Matrix<Scalar> &mat)
+    : _ptr(mat.ptr()), _rows(mat.rows()), _cols(mat.cols()),
+      _row_stride(mat.strides(0)), _col_stride(mat.strides(1))
+  {
+    // Pass...
+  }
+
+  /** Constructs a view to the elements of the given (temporary) matrix. */
+  MatrixView(Matrix<Scalar> &&mat)
+    : _ptr(mat.ptr()), _rows(mat.rows()), _cols(mat.cols()),
+      _row_stride(mat.strides(0)), _col_stride(mat.strides(1))
+  {
+    // Pass...
+  }
+
+  /** Returns the number of rows. */
+  inline size_t rows() const { return _rows; }
+  /** Returns the number of columns. */
+  inline size_t cols() const { return _cols; }
+  /** Returns the i-th stride (0: rows, 1: columns). */
+  inline size_t strides(size_t i) const { return (0 == i) ? _row_stride : _col_stride; }
+  /** Returns the pointer to the first element. */
+  inline Scalar *ptr() const { return _ptr; }
+
+  /** Returns true, if the storage-order of the matrix is row-major (C order). */
+  inline bool isRowMajor() const { return 1 == _col_stride; }
+
+  /** Returns a reference to the element (i,j). */
+  inline Scalar &operator() (size_t i, size_t j) const {
+    return _ptr[i*_row_stride + j*_col_stride];
+  }
+
+  /** Returns a view to the i-th row. */
+  inline VectorView<Scalar> row(size_t i) const {
+    return VectorView<Scalar>(_ptr + i*_row_stride, _cols, _col_stride);
+  }
+
+  /** Returns a view to the j-th column. */
+  inline VectorView<Scalar> col(size_t j) const {
+    return VectorView<Scalar>(_ptr + j*_col_stride, _rows, _row_stride);
+  }
+
+  /** Returns a view to the sub-matrix (block) of size @c nrow x @c ncol starting at (i,j). */
+  inline MatrixView<Scalar> sub(size_t i, size_t j, size_t nrow, size_t ncol) const {
+    return MatrixView<Scalar>(_ptr + i*_row_stride + j*_col_stride, nrow, ncol,
+                              _row_stride, _col_stride);
+  }
+
+  /** Returns a view to the transposed matrix. */
+  inline MatrixView<Scalar> t() const {
+    return MatrixView<Scalar>(_ptr, _cols, _rows, _col_stride, _row_stride);
+  }
+};
+
+
+
+/**
+ * Returns a view to the elements of a const vector, to be passed to arguments, that are only
+ * read by a routine (e.g. the operands of @c Blas::dot). Routines, that modify their arguments
+ * in place, must only receive views of non-const arrays.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline VectorView<Scalar> __readonly_view(const Vector<Scalar> &vec)
+{
+  return VectorView<Scalar>(const_cast<Scalar *>(vec.ptr()), vec.dim(), vec.stride());
+}
+
+
+/**
+ * Returns a view to the elements of a const matrix, to be passed to arguments, that are only
+ * read by a routine, see above.
+ *
+ * @ingroup matrix
+ */
+template <class Scalar>
+inline MatrixView<Scalar> __readonly_view(const Matrix<Scalar> &mat)
+{
+  return MatrixView<Scalar>(const_cast<Scalar *>(mat.ptr()), mat.rows(), mat.cols(),
+                            mat.strides(0), mat.strides(1));
+}
+
+}
+
+#endif // __LINALG_VIEW_HH__
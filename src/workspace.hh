@@ -9,7 +9,21 @@
 #ifndef __LINALG_WORKSPACE_HH__
 #define __LINALG_WORKSPACE_HH__
 
+#include "pool.hh"
+#include "view.hh"
+#include "memstats.hh"
 #include <cstdlib>
+#include <algorithm>
+
+
+/**
+ * Specifies the minimum size (in bytes) of a chunk allocated by a @c Linalg::Workspace.
+ *
+ * @ingroup linalg
+ */
+#ifndef LINALG_WORKSPACE_CHUNK_SIZE
+#define LINALG_WORKSPACE_CHUNK_SIZE (64*1024)
+#endif
 
 
 namespace Linalg {
@@ -18,33 +32,160 @@ namespace Linalg {
 /**
  * Semi-automatic workspace allocation for LAPACK routines.
  *
+ * A workspace is a bump (stack) allocator: Memory is handed out by @c alloc from a list of
+ * chunks and released all at once by popping the enclosing frame (see @c push, @c pop and
+ * @c Workspace::Frame). Chunks are kept after a frame is popped, hence once the workspace has
+ * grown to the high-water mark of a routine, repeated calls do not allocate any memory. All
+ * sub-allocations are aligned to @c LINALG_ALIGNMENT.
+ *
+ * Each thread has its own workspace, see @c Workspace::local(). A workspace itself is not
+ * thread-safe.
+ *
+ * @code
+ * Workspace::Frame frame;
+ * VectorView<double> v = frame.vector<double>(n);
+ * ... // use v
+ * // v is released as frame leaves the scope.
+ * @endcode
+ *
  * @ingroup linalg
  */
 class Workspace
 {
+public:
+  /**
+   * A position in the workspace, returned by @c push and passed to @c pop.
+   */
+  struct Mark {
+    /** The current chunk. */
+    void *chunk;
+    /** The offset into the current chunk. */
+    size_t offset;
+    /** The number of bytes in use. */
+    size_t used;
+  };
+
+  /**
+   * RAII frame: Pushes a frame onto the given (or thread-local) workspace on construction and
+   * pops it on destruction. Frames must be destroyed in reverse order of their construction.
+   */
+  class Frame
+  {
+  protected:
+    /** The workspace. */
+    Workspace &_ws;
+    /** The mark of the workspace at construction. */
+    Mark _mark;
+
+  public:
+    /** Pushes a frame onto the thread-local workspace. */
+    Frame()
+      : _ws(Workspace::local()), _mark(_ws.push())
+    {
+      // Pass...
+    }
+
+    /** Pushes a frame onto the given workspace. */
+    explicit Frame(Workspace &ws)
+      : _ws(ws), _mark(_ws.push())
+    {
+      // Pass...
+    }
+
+    /** Pops the frame, releasing all memory allocated within it. */
+    ~Frame() {
+      _ws.pop(_mark);
+    }
+
+    /** Allocates memory for @c n elements of type @c Scalar within the frame. */
+    template <class Scalar>
+    inline Scalar *alloc(size_t n) {
+      return _ws.alloc<Scalar>(n);
+    }
+
+    /** Allocates a vector of dimension @c n within the frame. */
+    template <class Scalar>
+    inline VectorView<Scalar> vector(size_t n) {
+      return VectorView<Scalar>(_ws.alloc<Scalar>(n), n, 1);
+    }
+
+    /** Allocates a column-major matrix of size @c rows x @c cols within the frame. */
+    template <class Scalar>
+    inline MatrixView<Scalar> matrix(size_t rows, size_t cols) {
+      return MatrixView<Scalar>(_ws.alloc<Scalar>(rows*cols), rows, cols, 1, rows);
+    }
+
+  private:
+    /** Frames can not be copied. */
+    Frame(const Frame &other);
+    /** Frames can not be copied. */
+    Frame &operator= (const Frame &other);
+  };
+
+
 protected:
   /**
-   * Holds the size of the allocated memory (in bytes).
+   * Header of a chunk, the memory follows the header.
+   */
+  struct Chunk {
+    /** The next chunk. */
+    Chunk *next;
+    /** The size of the memory (in bytes, without header). */
+    size_t size;
+    /** The @c MemStats tag of the chunk. */
+    const char *tag;
+  };
+
+  /** Size of the chunk header (padded to keep the data aligned). */
+  static inline size_t headerSize() {
+    return ((sizeof(Chunk) + LINALG_ALIGNMENT - 1)/LINALG_ALIGNMENT)*LINALG_ALIGNMENT;
+  }
+
+  /** Returns the pointer to the memory of the given chunk. */
+  static inline char *chunkData(Chunk *chunk) {
+    return reinterpret_cast<char *>(chunk) + headerSize();
+  }
+
+  /**
+   * Holds the size of the memory allocated by @c ensure (in bytes).
    */
   size_t _size;
 
   /**
-   * Holds a pointer to the allocated workspace memory.
+   * Holds a pointer to the memory allocated by @c ensure.
    */
   char *_data;
 
+  /**
+   * Holds the @c MemStats tag of the memory allocated by @c ensure.
+   */
+  const char *_data_tag;
+
+  /** The first chunk of the arena. */
+  Chunk *_first;
+  /** The chunk, allocations are currently served from. */
+  Chunk *_current;
+  /** The offset into the current chunk. */
+  size_t _offset;
+  /** The number of bytes currently in use (including alignment padding). */
+  size_t _used;
+  /** The maximum of @c _used since construction or the last @c resetHighWaterMark. */
+  size_t _high_water;
+  /** The number of active frames. */
+  size_t _depth;
+
 
 public:
   /**
-   * Creates a workspace with the given size (in bytes).
+   * Creates a workspace, preallocating @c size bytes.
    */
   Workspace(size_t size=0)
-    : _size(size), _data(0)
+    : _size(0), _data(0), _data_tag(0), _first(0), _current(0), _offset(0), _used(0), _high_water(0),
+      _depth(0)
   {
     // Preallocate some space:
-    if (0 < size)
-    {
-      this->_data = new char[size];
+    if (0 < size) {
+      reserve(size);
     }
   }
 
@@ -53,15 +194,24 @@ public:
    */
   ~Workspace()
   {
-    // Free workspace if allocated:
-    if (0 != this->_data)
-    {
-      delete[] this->_data;
+    release();
+    if (0 != _data) {
+      __aligned_free(_data);
+      MemStats::released(_size, _data_tag);
     }
   }
 
   /**
-   * Ensures that at least @c size elements are allocated for the working-memory.
+   * Returns the workspace of the calling thread.
+   */
+  static inline Workspace &local() {
+    static thread_local Workspace ws;
+    return ws;
+  }
+
+  /**
+   * Ensures that at least @c size elements are allocated for the working-memory. This buffer is
+   * independent of the arena, its content is lost if it gets reallocated.
    */
   template <class Scalar>
   Scalar *ensure(size_t size)
@@ -69,26 +219,156 @@ public:
     // If more space is requested than allocated -> allocate more
     if (this->_size < size*sizeof(Scalar))
     {
-      if (0 != this->_data)
-      {
-        delete[] this->_data;
+      if (0 != this->_data) {
+        __aligned_free(this->_data);
+        MemStats::released(this->_size, this->_data_tag);
       }
 
-      this->_data = (void *)new Scalar[size];
+      this->_data = 0; this->_size = 0;
+      this->_data = reinterpret_cast<char *>(__aligned_malloc(size*sizeof(Scalar)));
       this->_size = size*sizeof(Scalar);
+      this->_data_tag = MemStats::allocated(this->_size, "Workspace::ensure");
     }
 
-    return (Scalar *)_data;
+    return reinterpret_cast<Scalar *>(_data);
   }
 
+  /**
+   * Returns the number of elements available in the buffer allocated by @c ensure.
+   */
   template <class Scalar>
-  size_t size() {
+  size_t size() const {
     return _size/sizeof(Scalar);
   }
+
+  /**
+   * Pushes a new frame and returns the mark to be passed to @c pop.
+   */
+  inline Mark push() {
+    Mark mark; mark.chunk = _current; mark.offset = _offset; mark.used = _used;
+    _depth++;
+    return mark;
+  }
+
+  /**
+   * Pops the frame specified by the given mark, releasing all memory allocated since the
+   * corresponding call to @c push. The memory is kept for later allocations.
+   */
+  inline void pop(const Mark &mark) {
+    _current = reinterpret_cast<Chunk *>(mark.chunk);
+    _offset  = mark.offset;
+    _used    = mark.used;
+    _depth--;
+  }
+
+  /**
+   * Allocates @c bytes of memory aligned to @c LINALG_ALIGNMENT. The memory is valid until the
+   * enclosing frame is popped.
+   *
+   * @throws MemoryError If a new chunk can not be allocated.
+   */
+  inline void *allocBytes(size_t bytes)
+  {
+    bytes = ((bytes + LINALG_ALIGNMENT - 1)/LINALG_ALIGNMENT)*LINALG_ALIGNMENT;
+
+    // Serve from current chunk if possible:
+    if ((0 == _current) || (_offset+bytes > _current->size)) {
+      _used += (0 == _current) ? 0 : (_current->size - _offset);
+      nextChunk(bytes);
+    }
+
+    void *ptr = chunkData(_current) + _offset;
+    _offset += bytes; _used += bytes;
+    if (_used > _high_water) { _high_water = _used; }
+    return ptr;
+  }
+
+  /**
+   * Allocates memory for @c n elements of type @c Scalar. The elements are not initialized.
+   */
+  template <class Scalar>
+  inline Scalar *alloc(size_t n) {
+    return reinterpret_cast<Scalar *>(allocBytes(n*sizeof(Scalar)));
+  }
+
+  /**
+   * Ensures that at least @c bytes can be allocated without allocating a new chunk.
+   */
+  inline void reserve(size_t bytes) {
+    Mark mark = push(); allocBytes(bytes); pop(mark);
+  }
+
+  /**
+   * Returns all chunks to the system. There must be no active frame.
+   */
+  inline void release() {
+    while (0 != _first) {
+      Chunk *next = _first->next; freeChunk(_first); _first = next;
+    }
+    _current = 0; _offset = 0; _used = 0;
+  }
+
+  /** Returns the number of bytes currently in use. */
+  inline size_t used() const { return _used; }
+
+  /** Returns the total number of bytes held by the arena. */
+  inline size_t capacity() const {
+    size_t c = 0;
+    for (Chunk *chunk=_first; 0 != chunk; chunk = chunk->next) { c += chunk->size; }
+    return c;
+  }
+
+  /** Returns the maximum number of bytes in use at any time. */
+  inline size_t highWaterMark() const { return _high_water; }
+
+  /** Resets the high-water mark to the current usage. */
+  inline void resetHighWaterMark() { _high_water = _used; }
+
+  /** Returns the number of active frames. */
+  inline size_t depth() const { return _depth; }
+
+
+protected:
+  /**
+   * Advances to the next chunk, that can hold at least @c bytes. Chunks following the current
+   * one, that are too small, are replaced by a new chunk.
+   */
+  inline void nextChunk(size_t bytes)
+  {
+    Chunk *next = (0 == _current) ? _first : _current->next;
+    if ((0 == next) || (next->size < bytes)) {
+      // Release all following (unused) chunks that are too small:
+      size_t size = std::max(size_t(LINALG_WORKSPACE_CHUNK_SIZE), bytes);
+      while ((0 != next) && (next->size < bytes)) {
+        size = std::max(size, 2*next->size);
+        Chunk *tmp = next->next; freeChunk(next); next = tmp;
+      }
+      if ((0 == next) || (next->size < bytes)) {
+        Chunk *chunk = reinterpret_cast<Chunk *>(__aligned_malloc(headerSize()+size));
+        chunk->size = size; chunk->next = next; next = chunk;
+        chunk->tag = MemStats::allocated(size, "Workspace");
+      }
+      if (0 == _current) { _first = next; } else { _current->next = next; }
+    }
+
+    _current = next; _offset = 0;
+  }
+
+  /** Returns the given chunk to the system. */
+  static inline void freeChunk(Chunk *chunk) {
+    MemStats::released(chunk->size, chunk->tag);
+    __aligned_free(chunk);
+  }
+
+private:
+  /** Workspaces can not be copied. */
+  Workspace(const Workspace &other);
+  /** Workspaces can not be copied. */
+  Workspace &operator= (const Workspace &other);
 };
 
 
 }
 
 
-#endif // __FLUC_LINALG_WORKSPACE_HH__
+#endif // __LINALG_WORKSPACE_HH__
@@ -1,6 +1,16 @@
 #include "arraytest.hh"
 
 #include "array.hh"
+#include "matrix.hh"
+#include "array_operators.hh"
+#include "reduce.hh"
+#include "mapped.hh"
+#include "io.hh"
+#include "stream.hh"
+#include "blas/gemm.hh"
+#include <thread>
+#include <cstdio>
+#include <fstream>
 
 using namespace Linalg;
 
@@ -58,6 +68,497 @@ ArrayTest::testValueAssignment()
 }
 
 
+void
+ArrayTest::testRefCount()
+{
+  Matrix<double> A(3,2);
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+
+  // Data and manager are held in the same block:
+  UT_ASSERT(__is_aligned(A.ptr()));
+
+  {
+    Vector<double> a = A.col(0);
+    Matrix<double> B = A.sub(1,0, 2,2);
+    UT_ASSERT_EQUAL(A.refCount(), size_t(3));
+    B = A.t();
+    UT_ASSERT_EQUAL(A.refCount(), size_t(3));
+    B = B;
+    UT_ASSERT_EQUAL(A.refCount(), size_t(3));
+  }
+
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+  UT_ASSERT_EQUAL(Array<double>().refCount(), size_t(0));
+}
+
+void
+ArrayTest::testShape()
+{
+  Shape dims(3); dims[0] = 4; dims[1] = 3; dims[2] = 2;
+  Array<double> A(dims);
+
+  UT_ASSERT_EQUAL((int)A.ndim(), 3);
+  UT_ASSERT_EQUAL((int)A.shape().prod(), 24);
+  UT_ASSERT_EQUAL((int)A.strides(0), 6);
+  UT_ASSERT_EQUAL((int)A.strides(1), 2);
+  UT_ASSERT_EQUAL((int)A.strides(2), 1);
+
+  // Transposed view reverses shape and strides:
+  Array<double> B = A.t();
+  UT_ASSERT(B.shape() == A.shape().reversed());
+  UT_ASSERT(B.strides() == A.strides().reversed());
+
+  // Column-major strides:
+  Array<double> C(dims, false);
+  UT_ASSERT_EQUAL((int)C.strides(0), 1);
+  UT_ASSERT_EQUAL((int)C.strides(1), 4);
+  UT_ASSERT_EQUAL((int)C.strides(2), 12);
+
+  // Too many dimensions:
+  UT_ASSERT_THROW(Shape(LINALG_MAX_NDIM+1), ShapeError);
+}
+
+
+void
+ArrayTest::testIterator()
+{
+  Shape dims(3); dims[0] = 4; dims[1] = 3; dims[2] = 5;
+  Array<double> A(dims);
+  Shape idx(3);
+  for (idx[0]=0; idx[0]<4; idx[0]++) {
+    for (idx[1]=0; idx[1]<3; idx[1]++) {
+      for (idx[2]=0; idx[2]<5; idx[2]++) {
+        A.at(idx) = 100*idx[0] + 10*idx[1] + idx[2];
+      }
+    }
+  }
+
+  // Iteration order: dimension 0 varies fastest, for all storage orders and views.
+  Array<double> C = A.copy(false);
+  Shape sub_dims(3); sub_dims[0] = 2; sub_dims[1] = 3; sub_dims[2] = 3;
+  Array<double> S(A, A.offset() + 1*15 + 1, sub_dims, A.strides());
+  Array<double> views[4] = { A, C, A.t(), S };
+  for (size_t v=0; v<4; v++) {
+    Array<double> &V = views[v];
+    Shape i(3, 0); size_t count = 0;
+    Array<double>::const_iterator iter = V.const_begin();
+    for (; iter != V.const_end(); iter++, count++) {
+      UT_ASSERT_EQUAL(*iter, V.at(i));
+      for (size_t d=0; d<3; d++) {
+        if (++i[d] < V.shape(d)) { break; }
+        i[d] = 0;
+      }
+    }
+    UT_ASSERT_EQUAL(count, V.shape().prod());
+  }
+
+  // Value assignment between storage orders and into a strided sub-array:
+  Array<double> B(dims, false);
+  B.values() = 0.0;
+  Array<double> T(B, B.offset() + 1*1 + 1*12, sub_dims, B.strides());
+  T.values() = S;
+  for (idx[0]=0; idx[0]<4; idx[0]++) {
+    for (idx[1]=0; idx[1]<3; idx[1]++) {
+      for (idx[2]=0; idx[2]<5; idx[2]++) {
+        bool inside = (idx[0]>=1) && (idx[0]<3) && (idx[2]>=1) && (idx[2]<4);
+        UT_ASSERT_EQUAL(B.at(idx), inside ? A.at(idx) : 0.0);
+      }
+    }
+  }
+
+  // Element-wise operators:
+  Array<double> D = C + A;
+  D += A;
+  for (idx[0]=0; idx[0]<4; idx[0]++) {
+    for (idx[1]=0; idx[1]<3; idx[1]++) {
+      for (idx[2]=0; idx[2]<5; idx[2]++) {
+        UT_ASSERT_EQUAL(D.at(idx), 3*A.at(idx));
+      }
+    }
+  }
+  UT_ASSERT(all(C == A));
+  UT_ASSERT(any(B == A) && ! all(B == A));
+
+  // Loop simplification: a dense array is a single contiguous line, the sub-array keeps its
+  // inner line and merges the two outer dimensions.
+  StridedLoop<1> dense(A.shape(), &A.strides());
+  UT_ASSERT(dense.isContiguous());
+  UT_ASSERT_EQUAL(dense.inner(), size_t(60));
+  StridedLoop<1> strided(S.shape(), &S.strides());
+  UT_ASSERT(! strided.isContiguous());
+  UT_ASSERT_EQUAL(strided.ndim(), size_t(2));
+}
+
+void
+ArrayTest::testParallel()
+{
+  size_t threshold = OpenMP::getParallelThreshold();
+  OpenMP::setParallelThreshold(1);
+
+  // Odd sizes, such that ranges split lines:
+  Matrix<double> A = Matrix<double>::rand(131, 77);
+  Matrix<double> B(131, 77, false), C(131, 77);
+  B.values() = A;
+  C.values() = A.t().t() + B - A*2.0;
+  Matrix<double> S = A.sub(3,5, 100,50);
+  Matrix<double> T(100, 50, false); T.values() = 1.5;
+  T.values() = S + T;
+  for (size_t i=0; i<131; i++) {
+    for (size_t j=0; j<77; j++) {
+      UT_ASSERT_EQUAL(B(i,j), A(i,j));
+      UT_ASSERT_NEAR(C(i,j), 0.0);
+      if ((i<100) && (j<50)) { UT_ASSERT_EQUAL(T(i,j), A(i+3,j+5) + 1.5); }
+    }
+  }
+
+  Array<bool> eq = (B == A);
+  UT_ASSERT(all(eq));
+  B(130,76) += 1;
+  eq = (B == A);
+  UT_ASSERT(any(eq) && ! all(eq));
+
+  Matrix<double> Z = Matrix<double>::zeros(131, 77);
+  Matrix<double> Y = C*0.0;
+  UT_ASSERT(all(Z == Y));
+
+  OpenMP::setParallelThreshold(threshold);
+  UT_ASSERT_EQUAL(OpenMP::getParallelThreshold(), size_t(LINALG_PARALLEL_THRESHOLD));
+}
+
+void
+ArrayTest::testReduce()
+{
+  // Sizes not divisible by the SIMD unrolling, mixed storage orders and strided views:
+  Matrix<double> A = Matrix<double>::rand(37, 23);
+  Matrix<double> B(37, 23, false); B.values() = apply(A, [](double a) { return a - 0.5; });
+  Matrix<double> S = B.sub(2,3, 30,17);
+  Matrix<double> views[4] = { A, B, B.t(), S };
+
+  for (size_t v=0; v<4; v++) {
+    Matrix<double> &M = views[v];
+    double s = 0, mn = M(0,0), mx = M(0,0), ma = 0;
+    size_t ai = 0, aj = 0;
+    Vector<double> cs(M.cols()), rs(M.rows()), cmax(M.cols());
+    cs.values() = 0.0; rs.values() = 0.0; cmax.values() = 0.0;
+    for (size_t j=0; j<M.cols(); j++) {
+      for (size_t i=0; i<M.rows(); i++) {
+        s += M(i,j); mn = std::min(mn, M(i,j)); ma = std::max(ma, std::abs(M(i,j)));
+        if (M(i,j) > mx) { mx = M(i,j); ai = i; aj = j; }
+        cs(j) += M(i,j); rs(i) += M(i,j); cmax(j) = std::max(cmax(j), std::abs(M(i,j)));
+      }
+    }
+
+    UT_ASSERT(std::abs(sum(M) - s) < 1e-12);
+    UT_ASSERT(std::abs(mean(M) - s/(M.rows()*M.cols())) < 1e-12);
+    UT_ASSERT_EQUAL(min(M), mn);
+    UT_ASSERT_EQUAL(max(M), mx);
+    UT_ASSERT_EQUAL(maxabs(M), ma);
+    Shape idx = argmax(M);
+    UT_ASSERT_EQUAL(idx[0], ai); UT_ASSERT_EQUAL(idx[1], aj);
+    UT_ASSERT_EQUAL(M.at(argmin(M)), mn);
+
+    Vector<double> csum = sum(M, 0), rsum = sum(M, 1), cabs = maxabs(M, 0);
+    Vector<double> cmin = min(M, 0), rmax = max(M, 1), cmean = mean(M, 0);
+    UT_ASSERT_EQUAL(csum.dim(), M.cols()); UT_ASSERT_EQUAL(rsum.dim(), M.rows());
+    for (size_t j=0; j<M.cols(); j++) {
+      UT_ASSERT(std::abs(csum(j) - cs(j)) < 1e-12);
+      UT_ASSERT(std::abs(cmean(j) - cs(j)/M.rows()) < 1e-12);
+      UT_ASSERT_EQUAL(cabs(j), cmax(j));
+      UT_ASSERT_EQUAL(cmin(j), min(M.col(j)));
+    }
+    for (size_t i=0; i<M.rows(); i++) {
+      UT_ASSERT(std::abs(rsum(i) - rs(i)) < 1e-12);
+      UT_ASSERT_EQUAL(rmax(i), max(M.row(i)));
+    }
+  }
+
+  // Vectors and parallel reductions:
+  size_t threshold = OpenMP::getParallelThreshold();
+  OpenMP::setParallelThreshold(1);
+  Vector<double> x = A.col(4);
+  UT_ASSERT_EQUAL(x(argmax(x)), max(x));
+  UT_ASSERT_EQUAL(x(argmin(x)), min(x));
+  UT_ASSERT(std::abs(sum(A) - sum(Vector<double>(sum(A, 1)))) < 1e-12);
+  OpenMP::setParallelThreshold(threshold);
+
+  // Empty arrays and invalid axes:
+  UT_ASSERT_EQUAL(sum(Array<double>()), 0.0);
+  UT_ASSERT_THROW(max(Array<double>()), ShapeError);
+  UT_ASSERT_THROW(sum(A, 2), ShapeError);
+  UT_ASSERT_THROW(sum(static_cast<Array<double> &>(x), 0), ShapeError);
+}
+
+void
+ArrayTest::testBroadcast()
+{
+  Matrix<double> A = Matrix<double>::rand(7, 5);
+  Vector<double> x = A.row(2), c = A.col(1);
+  Vector<double> y(5); y.values() = x + x;
+  Shape cube(3); cube[0] = 2; cube[1] = 7; cube[2] = 5;
+
+  // Add a row vector to each row and scale each row by an element of c (without temporaries):
+  Matrix<double> B = A + x;
+  Matrix<double> C = mul(A, c.expand(1)) - div(x, y);
+  for (size_t i=0; i<7; i++) {
+    for (size_t j=0; j<5; j++) {
+      UT_ASSERT_EQUAL(B(i,j), A(i,j) + x(j));
+      UT_ASSERT_EQUAL(C(i,j), A(i,j)*c(i) - x(j)/y(j));
+    }
+  }
+
+  // Broadcasting assignment, in-place sum and comparison:
+  Matrix<double> D(7, 5, false); D.values() = x;
+  D += c.expand(1);
+  Array<bool> eq = (D == D.row(3));
+  for (size_t i=0; i<7; i++) {
+    for (size_t j=0; j<5; j++) {
+      UT_ASSERT_EQUAL(D(i,j), x(j) + c(i));
+      std::vector<size_t> idx(2); idx[0] = i; idx[1] = j;
+      UT_ASSERT_EQUAL(eq.at(idx), (D(i,j) == D(3,j)));
+    }
+  }
+  UT_ASSERT(all(D.broadcast(cube) == D));
+
+  // Incompatible shapes:
+  UT_ASSERT_THROW(A + c, ShapeError);
+  UT_ASSERT_THROW(D.values() = c, ShapeError);
+  UT_ASSERT_THROW(D.values() = D.broadcast(cube), ShapeError);
+}
+
+void
+ArrayTest::testMapped()
+{
+  UnitTest::TempFile file;
+  const std::string &filename = file.name();
+
+  {
+    // Create a file holding a 3x4 matrix behind a 16-byte header:
+    Matrix<double> A = mapMatrix(MappedDataMngr<double>::create(filename, 12, 16), 3, 4);
+    UT_ASSERT(0 != mapped(A));
+    UT_ASSERT(mapped(A)->isWritable());
+    for (size_t i=0; i<3; i++) {
+      for (size_t j=0; j<4; j++) {
+        UT_ASSERT_EQUAL(A(i,j), 0.0);
+        A(i,j) = 4*i+j;
+      }
+    }
+    mapped(A)->sync();
+
+    // Mapping survives sub-matrices:
+    Matrix<double> B = A.sub(1,1,2,2);
+    UT_ASSERT(mapped(A) == mapped(B));
+  }
+
+  {
+    // Read back:
+    Matrix<double> A = mapMatrix<double>(filename, 3, 4, true,
+                                         MappedDataMngr<double>::READ_ONLY, 16);
+    UT_ASSERT(! mapped(A)->isWritable());
+    mapped(A)->advise(MappedDataMngr<double>::SEQUENTIAL);
+    for (size_t i=0; i<3; i++) {
+      for (size_t j=0; j<4; j++) {
+        UT_ASSERT_EQUAL(A(i,j), double(4*i+j));
+      }
+    }
+
+    Vector<double> v = mapVector<double>(filename, 0, MappedDataMngr<double>::READ_ONLY, 16);
+    UT_ASSERT_EQUAL((int)v.dim(), 12);
+    UT_ASSERT_EQUAL(v(5), 5.0);
+  }
+
+  // Errors:
+  UT_ASSERT_THROW(mapVector<double>(filename, 13, MappedDataMngr<double>::READ_ONLY, 16), IOError);
+  UT_ASSERT_THROW(mapVector<double>("does/not/exist.bin"), IOError);
+  UT_ASSERT(0 == mapped(Matrix<double>(2,2)));
+}
+
+
+void
+ArrayTest::testBinaryIO()
+{
+  UnitTest::TempFile file, file2;
+  const std::string &filename = file.name(), &filename2 = file2.name();
+
+  Matrix<double> A = Matrix<double>::rand(5,3);
+  Matrix<double> B = Matrix<double>::rand(4,7).t();
+  TriMatrix<double> T = triu(Matrix<double>::rand(3,3), true);
+  Vector<double> x = A.col(1);
+
+  {
+    BinaryWriter out(filename);
+    out.write(A); out.write(B); out.write(T); out.write(x);
+    out.flush();
+  }
+
+  BinaryReader in(filename);
+  UT_ASSERT_EQUAL((int)in.count(), 4);
+  UT_ASSERT_EQUAL(in.header(1).flags & BinaryHeader::ROW_MAJOR, uint32_t(0));
+
+  Matrix<double> A2 = in.matrix<double>(0);
+  Matrix<double> B2 = in.matrix<double>(1);
+  TriMatrix<double> T2 = in.triMatrix<double>(2);
+  Vector<double> x2 = in.vector<double>(3);
+
+  // Payloads are mapped and aligned:
+  UT_ASSERT(0 != mapped(A2));
+  UT_ASSERT(__is_aligned(A2.ptr())); UT_ASSERT(__is_aligned(x2.ptr()));
+  UT_ASSERT_EQUAL((int)B2.strides(0), 1);
+  UT_ASSERT(T2.isUpper()); UT_ASSERT(T2.hasUnitDiag());
+
+  for (size_t i=0; i<5; i++) {
+    UT_ASSERT_EQUAL(x2(i), x(i));
+    for (size_t j=0; j<3; j++) { UT_ASSERT_EQUAL(A2(i,j), A(i,j)); }
+  }
+  for (size_t i=0; i<7; i++) {
+    for (size_t j=0; j<4; j++) { UT_ASSERT_EQUAL(B2(i,j), B(i,j)); }
+  }
+  for (size_t i=0; i<3; i++) {
+    for (size_t j=0; j<3; j++) { UT_ASSERT_EQUAL(T2(i,j), T(i,j)); }
+  }
+
+  // Errors:
+  UT_ASSERT_THROW(in.matrix<float>(0), IOError);
+  UT_ASSERT_THROW(in.matrix<double>(4), IOError);
+
+  // Corrupt headers (non-contiguous strides, overflowing shapes, inconsistent types):
+  for (int c=0; c<4; c++) {
+    save(filename2, Matrix<double>::rand(2,2));
+    std::fstream stream(filename2.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    BinaryHeader h; stream.read(reinterpret_cast<char *>(&h), sizeof(BinaryHeader));
+    if (0 == c) { h.strides[0] = 1; h.strides[1] = 1000000; }
+    if (1 == c) { h.shape[0] = h.shape[1] = uint64_t(1) << 32; h.strides[0] = h.shape[1]; }
+    if (2 == c) { h.shape[0] = uint64_t(1) << 61; h.strides[0] = h.shape[1] = 1; }
+    if (3 == c) { h.element_size = 4; }
+    stream.seekp(0); stream.write(reinterpret_cast<const char *>(&h), sizeof(BinaryHeader));
+    stream.close();
+    UT_ASSERT_THROW(BinaryReader reader(filename2), IOError);
+  }
+
+  // Single record:
+  save(filename2, A);
+  Matrix<double> A3 = loadMatrix<double>(filename2);
+  UT_ASSERT_EQUAL(A3(4,2), A(4,2));
+
+  // Empty records in the middle and at the end:
+  {
+    BinaryWriter out(filename);
+    out.write(Matrix<double>(0, 3)); out.write(x); out.write(Vector<double>(0));
+    out.flush();
+  }
+  BinaryReader in2(filename);
+  UT_ASSERT_EQUAL((int)in2.count(), 3);
+  Matrix<double> E = in2.matrix<double>(0);
+  UT_ASSERT_EQUAL((int)E.rows(), 0); UT_ASSERT_EQUAL((int)E.cols(), 3);
+  UT_ASSERT_EQUAL((int)in2.vector<double>(0).dim(), 0);
+  UT_ASSERT_EQUAL(in2.vector<double>(1)(4), x(4));
+  UT_ASSERT_EQUAL((int)in2.vector<double>(2).dim(), 0);
+  UT_ASSERT_EQUAL((int)in2.matrix<double>(2).rows(), 0);
+  save(filename2, Vector<double>(0));
+  UT_ASSERT_EQUAL((int)loadVector<double>(filename2).dim(), 0);
+  UT_ASSERT_EQUAL((int)loadMatrix<double>(filename2).cols(), 1);
+
+  // A size of 0 is no longer a request for the whole file:
+  UT_ASSERT_THROW(MappedDataMngr<double>::open(filename, MappedDataMngr<double>::READ_ONLY,
+                                               0, 0), IOError);
+}
+
+
+void
+ArrayTest::testStreaming()
+{
+  UnitTest::TempFile file;
+  const std::string &filename = file.name();
+  Matrix<double> A = Matrix<double>::rand(103, 4);
+
+  // Write row panels of 10 rows, every other one from a column-major copy (written through a
+  // contiguous copy):
+  {
+    Matrix<double> Acol = A.copy(false);
+    PanelWriter<double> out(filename, 103, 4);
+    for (size_t i=0; i<103; i+=10) {
+      out.write(((i/10) % 2 ? Acol : A).sub(i,0, std::min(size_t(10), 103-i),4));
+    }
+    UT_ASSERT_EQUAL((int)out.written(), 103);
+    out.close();
+    UT_ASSERT_THROW(out.write(A.sub(0,0,1,4)), IOError);
+  }
+  UT_ASSERT_THROW(PanelReader<double>(filename, 0), ShapeError);
+
+  // Build Gram matrix G = A^T A panel by panel:
+  {
+    PanelReader<double> in(filename, 16);
+    UT_ASSERT(in.rowPanels());
+    Matrix<double> G = Matrix<double>::zeros(4,4), P;
+    size_t n = 0;
+    while (in.next(P)) {
+      UT_ASSERT_EQUAL(in.offset(), n);
+      UT_ASSERT_EQUAL(P(0,2), A(n,2));
+      Blas::gemm(1., P.t(), P, 1., G);
+      n += P.rows();
+    }
+    UT_ASSERT_EQUAL((int)n, 103);
+    // End of stream is sticky:
+    UT_ASSERT(! in.next(P)); UT_ASSERT_EQUAL(in.offset(), size_t(96));
+
+    Matrix<double> G2 = Matrix<double>::zeros(4,4);
+    Blas::gemm(1., A.t(), A, 0., G2);
+    for (size_t i=0; i<4; i++) {
+      for (size_t j=0; j<4; j++) { UT_ASSERT_NEAR(G(i,j), G2(i,j)); }
+    }
+  }
+
+  // Column panels of a column-major record (second record):
+  {
+    Matrix<double> B = Matrix<double>::rand(6, 9).t();
+    BinaryWriter out(filename);
+    out.write(A); out.write(B); out.flush();
+
+    PanelReader<double> in(filename, 4, 1);
+    UT_ASSERT(! in.rowPanels());
+    Matrix<double> P;
+    size_t n = 0;
+    while (in.next(P)) {
+      for (size_t j=0; j<P.cols(); j++) {
+        for (size_t i=0; i<9; i++) { UT_ASSERT_EQUAL(P(i,j), B(i,n+j)); }
+      }
+      n += P.cols();
+    }
+    UT_ASSERT_EQUAL((int)n, 6);
+  }
+
+  // Through a pipe:
+  {
+    int fds[2]; UT_ASSERT(0 == pipe(fds));
+    std::thread writer([&A, &fds]() {
+      PanelWriter<double> out(fds[1], 103, 4);
+      out.write(A);
+      close(fds[1]);
+    });
+
+    PanelReader<double> in(fds[0], 50);
+    Matrix<double> P;
+    size_t n = 0;
+    while (in.next(P)) {
+      UT_ASSERT_EQUAL(P(P.rows()-1,3), A(n+P.rows()-1,3));
+      n += P.rows();
+    }
+    writer.join(); close(fds[0]);
+    UT_ASSERT_EQUAL((int)n, 103);
+  }
+
+  // Truncated file:
+  {
+    PanelWriter<double> out(filename, 103, 4);
+    out.write(A.sub(0,0,10,4));
+    UT_ASSERT_THROW(out.close(), IOError);
+  }
+  PanelReader<double> in(filename, 8);
+  Matrix<double> P;
+  UT_ASSERT(in.next(P));
+  UT_ASSERT_THROW(while (in.next(P)) {}, IOError);
+  UT_ASSERT_THROW(in.next(P), IOError);
+}
+
 
 UnitTest::TestSuite *
 ArrayTest::suite()
@@ -70,5 +571,32 @@ ArrayTest::suite()
   s->addTest(new UnitTest::TestCaller<ArrayTest>(
                "double[m,n] value assignment", &ArrayTest::testValueAssignment));
 
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] reference counting", &ArrayTest::testRefCount));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n,k] shape and strides", &ArrayTest::testShape));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n,k] iterators and element-wise ops", &ArrayTest::testIterator));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] parallel element-wise ops", &ArrayTest::testParallel));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] reductions", &ArrayTest::testReduce));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] broadcasting", &ArrayTest::testBroadcast));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] memory-mapped file", &ArrayTest::testMapped));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] binary container", &ArrayTest::testBinaryIO));
+
+  s->addTest(new UnitTest::TestCaller<ArrayTest>(
+               "double[m,n] panel streaming", &ArrayTest::testStreaming));
+
   return s;
 }
@@ -8,6 +8,15 @@ class ArrayTest : public UnitTest::TestCase
 public:
   void testAssignment();
   void testValueAssignment();
+  void testRefCount();
+  void testShape();
+  void testIterator();
+  void testParallel();
+  void testReduce();
+  void testBroadcast();
+  void testMapped();
+  void testBinaryIO();
+  void testStreaming();
 
 public:
   static UnitTest::TestSuite *suite();
@@ -0,0 +1,116 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+/*
+ * Measures the time per element of the dense BLAS level 1 reductions (dot and nrm2sq) against
+ * the vector length, for all SIMD levels supported by the CPU, compared to a loop with a single
+ * vector accumulator. On x86, the time is given in (TSC reference) cycles per element,
+ * otherwise in nanoseconds per element.
+ *
+ * Usage: linalg-blas1-bench [max N] [elements per measurement]
+ * (build with CMAKE_BUILD_TYPE=Release, unoptimized builds measure the compiler)
+ */
+
+#include "vector.hh"
+#include "blas/dot.hh"
+#include "blas/nrm2.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+using namespace Linalg;
+
+
+/* Returns the current value of the time-stamp counter or the time in nanoseconds. */
+static inline double
+__ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return double(__rdtsc());
+#else
+  return double(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+
+/* The dot product with a single vector accumulator (the latency-bound reference). */
+static double
+__dot_single(size_t N, const double *x, const double *y)
+{
+  typedef SIMDTraits<double>::uvector vec;
+  const vec *x_ptr = (const vec *)x, *y_ptr = (const vec *)y;
+  vec res; res.d[0] = res.d[1] = 0;
+  for (size_t i=0; i<N/2; i++) { res.v += x_ptr[i].v * y_ptr[i].v; }
+  for (size_t i=2*(N/2); i<N; i++) { res.d[0] += x[i]*y[i]; }
+  return res.d[0] + res.d[1];
+}
+
+
+/* Returns the ticks per element of the given reduction, which is repeated until about
+ * @c elements elements are processed. */
+template <class Func>
+static double
+__bench(size_t N, size_t elements, Func func)
+{
+  size_t repeats = std::max(size_t(1), elements/N);
+  volatile double sink = func(); (void)sink;
+
+  double start = __ticks();
+  for (size_t r=0; r<repeats; r++) { sink = func(); }
+  return (__ticks() - start)/(double(repeats)*N);
+}
+
+
+int main(int argc, char *argv[])
+{
+  size_t max_N    = (argc > 1) ? std::atoi(argv[1]) : (1 << 22);
+  size_t elements = (argc > 2) ? std::atoi(argv[2]) : (1 << 26);
+
+  Vector<double> x = Vector<double>::rand(max_N, 1), y = Vector<double>::rand(max_N, 2);
+  SIMD::Level best = SIMD::supported();
+
+  std::cout << "Dense dot/nrm2sq, "
+#if defined(__x86_64__) || defined(__i386__)
+            << "cycles (TSC) per element, "
+#else
+            << "ns per element, "
+#endif
+            << "best SIMD level: " << SIMD::name(best) << std::endl;
+  std::cout << std::setw(12) << "N" << std::setw(12) << "1-acc";
+  for (int l=SIMD::BASE; l<=best; l++) {
+    std::cout << std::setw(12) << (std::string("dot ") + SIMD::name(SIMD::Level(l)));
+  }
+  for (int l=SIMD::BASE; l<=best; l++) {
+    std::cout << std::setw(12) << (std::string("nrm ") + SIMD::name(SIMD::Level(l)));
+  }
+  std::cout << std::endl;
+
+  for (size_t N=16; N<=max_N; N*=4) {
+    const double *xp = x.ptr(), *yp = y.ptr();
+    std::cout << std::setw(12) << N << std::fixed << std::setprecision(3) << std::setw(12)
+              << __bench(N, elements, [&]() { return __dot_single(N, xp, yp); });
+    for (int l=SIMD::BASE; l<=best; l++) {
+      SIMD::setLevel(SIMD::Level(l));
+      std::cout << std::setw(12)
+                << __bench(N, elements, [&]() { return Blas::__dot_dense(N, xp, yp); });
+    }
+    for (int l=SIMD::BASE; l<=best; l++) {
+      SIMD::setLevel(SIMD::Level(l));
+      std::cout << std::setw(12)
+                << __bench(N, elements, [&]() { return Blas::__nrm2sq_dense(N, xp); });
+    }
+    std::cout << std::endl;
+  }
+
+  return 0;
+}
@@ -3,8 +3,13 @@
 #include "vector.hh"
 #include "matrix.hh"
 #include "blas/dot.hh"
+#include "blas/axpy.hh"
+#include "blas/scal.hh"
+#include "blas/nrm2.hh"
 #include "operators.hh"
 
+#include <complex>
+
 using namespace Linalg;
 
 
@@ -80,6 +85,108 @@ void DOTTest::testHugeDense()
 }
 
 
+void DOTTest::testDispatch()
+{
+  // Compare the dense kernels of all supported instruction sets against the incremental ones,
+  // for short lengths, lengths not divisible by the vector width and (mutually) unaligned
+  // starts, as given by sub-vectors:
+  Vector<double> x = Vector<double>::rand(203, 1), y = Vector<double>::rand(203, 2);
+  float xf[203], yf[203];
+  for (size_t i=0; i<203; i++) { xf[i] = x(i); yf[i] = y(i); }
+  size_t lengths[6] = { 0, 1, 3, 7, 17, 190 };
+
+  SIMD::Level initial = SIMD::level();
+  for (int l=SIMD::BASE; l<=SIMD::AVX512; l++) {
+    SIMD::setLevel(SIMD::Level(l));
+    for (size_t ox=0; ox<9; ox++) {
+      for (size_t k=0; k<6; k++) {
+        size_t oy = (ox*5) % 9, N = lengths[k];
+        double ref = Blas::__dot_incremental(N, x.ptr()+ox, 1, y.ptr()+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dot_dense(N, x.ptr()+ox, y.ptr()+oy) - ref) <= 1e-12*ref);
+        ref = Blas::__nrm2sq_incremental(N, x.ptr()+ox, 1);
+        UT_ASSERT(std::abs(Blas::__nrm2sq_dense(N, x.ptr()+ox) - ref) <= 1e-12*ref);
+        float reff = Blas::__dot_incremental(N, xf+ox, 1, yf+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dot_dense(N, xf+ox, yf+oy) - reff) <= 1e-5*reff);
+
+        Vector<double> z = y.copy();
+        Blas::__axpy_dense(2.0, N, x.ptr()+ox, z.ptr()+oy);
+        Blas::__scal_dense(N, 0.5, z.ptr()+oy);
+        for (size_t i=0; i<203; i++) {
+          bool inside = (i >= oy) && (i < oy+N);
+          double expected = inside ? (0.5*(y(i) + 2.0*x(i-oy+ox))) : y(i);
+          UT_ASSERT(std::abs(z(i) - expected) < 1e-15);
+        }
+      }
+    }
+  }
+  SIMD::setLevel(initial);
+}
+
+
+void DOTTest::testComplex()
+{
+  // Compare the dense complex kernels of all supported instruction sets against the
+  // incremental ones, also for complex<double> vectors that are not 16-byte aligned:
+  typedef std::complex<double> cdouble;
+  typedef std::complex<float> cfloat;
+  double xbuf[2*203+1], ybuf[2*203];
+  cdouble *x = (cdouble *)(xbuf+1), *y = (cdouble *)ybuf;
+  cfloat xf[203], yf[203];
+  for (size_t i=0; i<203; i++) {
+    x[i] = cdouble(std::sin(i), std::cos(3.*i)); y[i] = cdouble(std::cos(2.*i), std::sin(5.*i));
+    xf[i] = cfloat(x[i]); yf[i] = cfloat(y[i]);
+  }
+  size_t lengths[6] = { 0, 1, 3, 7, 17, 190 };
+  cdouble alpha(0.5, -2.0), a(-1.5, 0.25);
+
+  SIMD::Level initial = SIMD::level();
+  for (int l=SIMD::BASE; l<=SIMD::AVX512; l++) {
+    SIMD::setLevel(SIMD::Level(l));
+    for (size_t ox=0; ox<9; ox++) {
+      for (size_t k=0; k<6; k++) {
+        size_t oy = (ox*5) % 9, N = lengths[k];
+        cdouble ref = Blas::__dot_incremental(N, x+ox, 1, y+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dot_dense(N, x+ox, y+oy) - ref) <= 1e-13*(N+1));
+        ref = Blas::__dotc_incremental(N, x+ox, 1, y+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dotc_dense(N, x+ox, y+oy) - ref) <= 1e-13*(N+1));
+        cfloat reff = Blas::__dotc_incremental(N, xf+ox, 1, yf+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dotc_dense(N, xf+ox, yf+oy) - reff) <= 1e-5*(N+1));
+        reff = Blas::__dot_incremental(N, xf+ox, 1, yf+oy, 1);
+        UT_ASSERT(std::abs(Blas::__dot_dense(N, xf+ox, yf+oy) - reff) <= 1e-5*(N+1));
+
+        cdouble z[203];
+        for (size_t i=0; i<203; i++) { z[i] = y[i]; }
+        Blas::__axpy_dense(alpha, N, x+ox, z+oy);
+        Blas::__scal_dense(N, a, z+oy);
+        for (size_t i=0; i<203; i++) {
+          bool inside = (i >= oy) && (i < oy+N);
+          cdouble expected = inside ? (a*(y[i] + alpha*x[i-oy+ox])) : y[i];
+          UT_ASSERT(std::abs(z[i] - expected) < 1e-14);
+        }
+      }
+    }
+  }
+  SIMD::setLevel(initial);
+
+  // Public interface, dense and strided:
+  Matrix<cdouble> A = Matrix<cdouble>::empty(17, 3);
+  for (size_t i=0; i<17; i++) {
+    for (size_t j=0; j<3; j++) { A(i,j) = x[3*i+j]; }
+  }
+  Vector<cdouble> u = A.col(0).copy(), v = A.col(1).copy();
+  cdouble ref = Blas::__dotc_incremental(17, x, 3, x+1, 3);
+  UT_ASSERT(std::abs(Blas::dotc(u, v) - ref) <= 1e-13*17);
+  UT_ASSERT(std::abs(Blas::dotc(A.col(0), A.col(1)) - ref) <= 1e-13*17);
+  UT_ASSERT(std::abs(Blas::dotc(v, u) - std::conj(ref)) <= 1e-13*17);
+  ref = Blas::__dot_incremental(17, x, 3, x+1, 3);
+  UT_ASSERT(std::abs(Blas::dot(u, v) - ref) <= 1e-13*17);
+  UT_ASSERT(std::abs(Blas::dot(A.col(0), A.col(1)) - ref) <= 1e-13*17);
+  Vector<double> r = Vector<double>::empty(4), q = Vector<double>::empty(4);
+  for (size_t i=0; i<4; i++) { r(i) = 2; q(i) = i; }
+  UT_ASSERT_EQUAL(Blas::dotc(r, q), 12.0);
+}
+
+
 UnitTest::TestSuite *
 DOTTest::suite()
 {
@@ -103,5 +210,11 @@ DOTTest::suite()
   s->addTest(new UnitTest::TestCaller<DOTTest>(
                "Blas::dot(double[m], double[m]) (huge-dense)", &DOTTest::testHugeDense));
 
+  s->addTest(new UnitTest::TestCaller<DOTTest>(
+               "Blas::dot(double[m], double[m]) (SIMD dispatch)", &DOTTest::testDispatch));
+
+  s->addTest(new UnitTest::TestCaller<DOTTest>(
+               "Blas::dot/dotc/axpy/scal(complex[m]) (SIMD dispatch)", &DOTTest::testComplex));
+
   return s;
 }
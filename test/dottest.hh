@@ -23,6 +23,8 @@ public:
 
   void testHugeIncr();
   void testHugeDense();
+  void testDispatch();
+  void testComplex();
 
 
 public:
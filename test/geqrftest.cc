@@ -74,6 +74,34 @@ GEQRFTest::testRealMN()
 }
 
 
+void
+GEQRFTest::testWorkspace()
+{
+  Matrix<double> A = this->A.copy();
+  Lapack::geqrf(A, tau);
+
+  // Warm up thread-local workspace:
+  Matrix<double> B = this->A.copy();
+  Lapack::ormqr(A, tau, B, true, true);
+  for (size_t i=0; i<3; i++) {
+    for (size_t j=i; j<3; j++) {
+      UT_ASSERT_NEAR(B(i,j), A(i,j));
+    }
+  }
+
+  // Steady state: No further chunks are allocated, all memory is released.
+  Workspace &ws = Workspace::local();
+  size_t capacity = ws.capacity();
+  for (size_t k=0; k<10; k++) {
+    B = this->A.copy();
+    Lapack::ormqr(A, tau, B, true, true);
+  }
+  UT_ASSERT_EQUAL(ws.capacity(), capacity);
+  UT_ASSERT_EQUAL(ws.used(), size_t(0));
+  UT_ASSERT_EQUAL(ws.depth(), size_t(0));
+}
+
+
 UnitTest::TestSuite *
 GEQRFTest::suite()
 {
@@ -85,5 +113,8 @@ GEQRFTest::suite()
   s->addTest(new UnitTest::TestCaller<GEQRFTest>(
                "Lapack::geqrf(double[m,n])", &GEQRFTest::testRealMN));
 
+  s->addTest(new UnitTest::TestCaller<GEQRFTest>(
+               "Lapack::ormqr(double[n,n]) thread-local workspace", &GEQRFTest::testWorkspace));
+
   return s;
 }
@@ -17,6 +17,7 @@ public:
 
   void testRealNN();
   void testRealMN();
+  void testWorkspace();
 
 public:
   static UnitTest::TestSuite *suite();
@@ -4,6 +4,7 @@
 #include "arraytest.hh"
 #include "matrixtest.hh"
 #include "trimatrixtest.hh"
+#include "pooltest.hh"
 
 #include "nrm2test.hh"
 #include "dottest.hh"
@@ -30,6 +31,7 @@ int main(void)
   runner.addSuite(ArrayTest::suite());
   runner.addSuite(MatrixTest::suite());
   runner.addSuite(TriMatrixTest::suite());
+  runner.addSuite(PoolTest::suite());
 
   runner.addSuite(NRM2Test::suite());
   runner.addSuite(DOTTest::suite());
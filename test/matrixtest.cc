@@ -1,5 +1,15 @@
 #include "matrixtest.hh"
 #include "matrix.hh"
+#include "trimatrix.hh"
+#include "view.hh"
+#include "numa.hh"
+#include "cow.hh"
+#include "expression.hh"
+#include "matrix_operators.hh"
+#include "array_operators.hh"
+#include "blas/dot.hh"
+#include <vector>
+#include <type_traits>
 
 using namespace Linalg;
 
@@ -131,6 +141,345 @@ MatrixTest::testSwap()
 }
 
 
+void
+MatrixTest::testAlignment()
+{
+  Matrix<double> A(5,3);
+  UT_ASSERT(__is_aligned(A.ptr()));
+
+  // Padded row-major: Each row starts at a cache line
+  Matrix<double> B = Matrix<double>::padded(5,3);
+  UT_ASSERT_EQUAL((int)B.strides(0), (int)(LINALG_ALIGNMENT/sizeof(double)));
+  UT_ASSERT_EQUAL((int)B.strides(1), 1);
+  for (size_t i=0; i<B.rows(); i++) {
+    UT_ASSERT(__is_aligned(B.row(i).ptr()));
+  }
+
+  // Padded col-major: Each column starts at a cache line
+  Matrix<float> C = Matrix<float>::padded(17,3, false);
+  UT_ASSERT_EQUAL((int)C.strides(0), 1);
+  UT_ASSERT_EQUAL((int)C.strides(1), (int)(2*LINALG_ALIGNMENT/sizeof(float)));
+  for (size_t j=0; j<C.cols(); j++) {
+    UT_ASSERT(__is_aligned(C.col(j).ptr()));
+  }
+
+  Vector<double> x(7);
+  UT_ASSERT(__is_aligned(x.ptr()));
+}
+
+void
+MatrixTest::testMove()
+{
+  Matrix<double> A = Matrix<double>::rand(3,2);
+  const double *ptr = A.ptr();
+
+  // Move construction takes the data, leaves A empty:
+  Matrix<double> B(std::move(A));
+  UT_ASSERT(ptr == B.ptr());
+  UT_ASSERT_EQUAL(B.refCount(), size_t(1));
+  UT_ASSERT_EQUAL((int)A.ndim(), 0);
+  UT_ASSERT_EQUAL(A.refCount(), size_t(0));
+
+  // Moved-from matrix is still assignable:
+  A = Matrix<double>::zeros(2,2);
+  UT_ASSERT_EQUAL((int)A.rows(), 2);
+
+  // Move assignment:
+  A = std::move(B);
+  UT_ASSERT(ptr == A.ptr());
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+
+  // No references are leaked by STL containers:
+  std::vector< Matrix<double> > list;
+  for (size_t i=0; i<10; i++) {
+    list.push_back(A);
+  }
+  UT_ASSERT_EQUAL(A.refCount(), size_t(11));
+  list.clear();
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+
+  // TriMatrix keeps its flags:
+  TriMatrix<double> T = triu(Matrix<double>::rand(3,3), true);
+  TriMatrix<double> U(std::move(T));
+  UT_ASSERT(U.isUpper()); UT_ASSERT(U.hasUnitDiag());
+}
+
+void
+MatrixTest::testView()
+{
+  Matrix<double> A = Matrix<double>::rand(4,3);
+  MatrixView<double> Av(A);
+
+  // Views do not hold a reference:
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+  UT_ASSERT_EQUAL((int)Av.rows(), 4); UT_ASSERT_EQUAL((int)Av.cols(), 3);
+
+  // Element access, sub-matrices and transposition match the matrix:
+  MatrixView<double> Asub = Av.sub(1,1, 3,2);
+  MatrixView<double> At = Av.t();
+  for (size_t i=0; i<4; i++) {
+    for (size_t j=0; j<3; j++) {
+      UT_ASSERT_EQUAL(Av(i,j), A(i,j));
+      UT_ASSERT_EQUAL(At(j,i), A(i,j));
+    }
+  }
+  UT_ASSERT_EQUAL(Asub(0,0), A(1,1)); UT_ASSERT_EQUAL(Asub(2,1), A(3,2));
+
+  // Writes through a view:
+  Av.col(1)(2) = 42.;
+  UT_ASSERT_EQUAL(A(2,1), 42.);
+
+  // BLAS on views:
+  VectorView<double> r = Av.row(0), c = Av.col(0);
+  UT_ASSERT_NEAR(Blas::dot(r, r), A(0,0)*A(0,0)+A(0,1)*A(0,1)+A(0,2)*A(0,2));
+  UT_ASSERT_NEAR(Blas::dot(c.sub(0,3), r),
+                 A(0,0)*A(0,0)+A(1,0)*A(0,1)+A(2,0)*A(0,2));
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+
+  // Writable views can not be created from const arrays, only read-only views:
+  UT_ASSERT((! std::is_convertible<const Matrix<double> &, MatrixView<double> >::value));
+  UT_ASSERT((! std::is_convertible<const Vector<double> &, VectorView<double> >::value));
+  const Matrix<double> &B = A;
+  UT_ASSERT(__readonly_view(B).ptr() == A.ptr());
+  UT_ASSERT_EQUAL(Blas::dot(Vector<double>(A.row(1)), Vector<double>(A.row(1))),
+                  Blas::dot(Av.row(1), Av.row(1)));
+}
+
+
+void
+MatrixTest::testNUMA()
+{
+  NUMA::Policy policies[4] = {NUMA::SERIAL, NUMA::FIRST_TOUCH, NUMA::INTERLEAVE, NUMA::BIND};
+
+  for (size_t p=0; p<4; p++) {
+    NUMA::Scope scope(policies[p]);
+    UT_ASSERT_EQUAL(NUMA::policy(), policies[p]);
+
+    // Large enough to span several pages:
+    Matrix<double> A = Matrix<double>::zeros(300, 200);
+    for (size_t i=0; i<300; i++) {
+      for (size_t j=0; j<200; j++) {
+        UT_ASSERT_EQUAL(A(i,j), 0.0);
+      }
+    }
+
+    // Vectors and arrays are placed the same way:
+    Vector<double> x = Vector<double>::zero(60000);
+    for (size_t i=0; i<x.dim(); i++) { UT_ASSERT_EQUAL(x(i), 0.0); }
+    Shape shape(3); shape[0] = 30; shape[1] = 40; shape[2] = 50;
+    Array<double> X(shape); X.values() = x.sub(0, 50);
+    UT_ASSERT_EQUAL(X.ptr()[30*40*50-1], 0.0);
+  }
+
+  // Policy is restored:
+  UT_ASSERT_EQUAL(NUMA::policy(), NUMA::FIRST_TOUCH);
+}
+
+
+void
+MatrixTest::testCopyOnWrite()
+{
+  CopyOnWriteStats::resetDetaches();
+  Matrix<double> A = Matrix<double>::rand(3,3).copy(false);
+  double a00 = A(0,0);
+
+  // Read access does not copy:
+  CopyOnWrite< Matrix<double> > B(A);
+  UT_ASSERT(B.isShared());
+  UT_ASSERT(A.ptr() == B.get().ptr());
+  UT_ASSERT_EQUAL(B.get()(1,2), A(1,2));
+  UT_ASSERT_EQUAL(CopyOnWriteStats::detaches(), size_t(0));
+
+  // First write detaches, keeping the storage order:
+  B.mut()(0,0) = a00+1;
+  UT_ASSERT_EQUAL(A(0,0), a00);
+  UT_ASSERT_EQUAL(B.get()(0,0), a00+1);
+  UT_ASSERT(! B.get().isRowMajor());
+  UT_ASSERT(! B.isShared());
+  UT_ASSERT_EQUAL(A.refCount(), size_t(1));
+
+  // Further writes do not copy:
+  B.mut()(1,1) = 0;
+  UT_ASSERT_EQUAL(B.handleDetaches(), size_t(1));
+  UT_ASSERT_EQUAL(CopyOnWriteStats::detaches(), size_t(1));
+
+  // Unshared data is not copied:
+  CopyOnWrite< Matrix<double> > C(Matrix<double>::rand(2,2));
+  C.mut()(0,0) = 1;
+  UT_ASSERT_EQUAL(C.handleDetaches(), size_t(0));
+
+  // Unshared external data is copied:
+  double buffer[3] = {1, 2, 3};
+  CopyOnWrite< Vector<double> > x(
+        Vector<double>(DataPtr<double>(new DataMngr<double>(buffer, false)), 0, 3, 1));
+  UT_ASSERT(! x.isShared()); UT_ASSERT(! x.isPrivate());
+  x.mut()(0) = 42;
+  UT_ASSERT_EQUAL(buffer[0], 1.); UT_ASSERT_EQUAL(x.get()(0), 42.);
+  UT_ASSERT(x.isPrivate());
+  UT_ASSERT_EQUAL(CopyOnWriteStats::detaches(), size_t(2));
+
+  // Type and flags are preserved:
+  CopyOnWrite< TriMatrix<double> > T(tril(A, true));
+  T.mut().ptr()[2*T.get().strides(0)] = 42;
+  UT_ASSERT(! T.get().isUpper()); UT_ASSERT(T.get().hasUnitDiag());
+  UT_ASSERT(42 != A(2,0));
+  UT_ASSERT_EQUAL(CopyOnWriteStats::detaches(), size_t(3));
+}
+
+
+void
+MatrixTest::testExpression()
+{
+  Matrix<double> A = Matrix<double>::rand(5,7), B = Matrix<double>::rand(5,7);
+  Matrix<double> C(5,7,false); C.values() = Matrix<double>::rand(5,7);
+
+  // Fused evaluation into an existing matrix, mixing storage orders:
+  Matrix<double> D(5,7);
+  D.values() = A + B - 2.0*C/4.0;
+  for (size_t i=0; i<5; i++) {
+    for (size_t j=0; j<7; j++) {
+      UT_ASSERT_NEAR(D(i,j), A(i,j) + B(i,j) - 0.5*C(i,j));
+    }
+  }
+
+  // Evaluation into a new matrix, a strided sub-matrix and in-place:
+  Matrix<double> E = -(A - B);
+  Matrix<double> F = Matrix<double>::zeros(7,7);
+  Matrix<double> G = F.sub(1,0, 5,7);
+  G.values() = apply(A.t().t(), [](double x) { return x*x; });
+  A.values() = A*2.0;
+  for (size_t i=0; i<5; i++) {
+    for (size_t j=0; j<7; j++) {
+      UT_ASSERT_NEAR(E(i,j), B(i,j) - A(i,j)/2);
+      UT_ASSERT_NEAR(F(i+1,j), A(i,j)*A(i,j)/4);
+      UT_ASSERT_EQUAL(F(0,j), 0.0);
+    }
+  }
+
+  // Vectors:
+  Vector<double> x = A.row(1), y = B.col(2);
+  UT_ASSERT_THROW(x + y, ShapeError);
+  Vector<double> z = x - x;
+  UT_ASSERT_EQUAL(z.dim(), x.dim());
+  UT_ASSERT_EQUAL(z(3), 0.0);
+
+  // Expressions as operands of the matrix product:
+  Matrix<double> P = Matrix<double>::rand(4,4), Q = Matrix<double>::rand(4,4);
+  Matrix<double> R = Matrix<double>::rand(4,4);
+  Vector<double> v = Vector<double>::rand(4);
+  Matrix<double> PQR = P * (Q + R), QRP = (Q - R) * P, QRQR = (Q + R) * (Q - R);
+  Vector<double> QRv = (Q + R) * v;
+  for (size_t i=0; i<4; i++) {
+    double sv = 0;
+    for (size_t j=0; j<4; j++) {
+      double s1 = 0, s2 = 0, s3 = 0;
+      for (size_t k=0; k<4; k++) {
+        s1 += P(i,k)*(Q(k,j)+R(k,j)); s2 += (Q(i,k)-R(i,k))*P(k,j);
+        s3 += (Q(i,k)+R(i,k))*(Q(k,j)-R(k,j));
+      }
+      UT_ASSERT_NEAR(PQR(i,j), s1); UT_ASSERT_NEAR(QRP(i,j), s2); UT_ASSERT_NEAR(QRQR(i,j), s3);
+      sv += (Q(i,j)+R(i,j))*v(j);
+    }
+    UT_ASSERT_NEAR(QRv(i), sv);
+  }
+
+  // Shape mismatches:
+  UT_ASSERT_THROW(A + A.t(), ShapeError);
+  UT_ASSERT_THROW(F.values() = A + B, ShapeError);
+}
+
+void
+MatrixTest::testTranspose()
+{
+  // Layout conversion of matrices, strided views and 3D arrays by the blocked transpose:
+  Matrix<double> A = Matrix<double>::rand(37, 53);
+  Matrix<double> views[3] = { A, A.sub(3, 5, 30, 41), A.t() };
+  for (size_t v=0; v<3; v++) {
+    Matrix<double> C = views[v].copy(false), R = C.copy(true);
+    UT_ASSERT(! C.isRowMajor()); UT_ASSERT(R.isRowMajor());
+    for (size_t i=0; i<C.rows(); i++) {
+      for (size_t j=0; j<C.cols(); j++) {
+        UT_ASSERT_EQUAL(C(i,j), views[v](i,j));
+        UT_ASSERT_EQUAL(R(i,j), views[v](i,j));
+      }
+    }
+  }
+
+  Shape shape(3); shape[0] = 5; shape[1] = 19; shape[2] = 23;
+  Array<double> X(shape, true);
+  for (size_t k=0; k<5*19*23; k++) { X.ptr()[k] = k; }
+  Array<double> Y = X.copy(false);
+  UT_ASSERT(all(Y == X));
+
+  // Parallel conversion:
+  size_t threshold = OpenMP::getParallelThreshold();
+  OpenMP::setParallelThreshold(1);
+  Matrix<double> P = A.copy(false);
+  OpenMP::setParallelThreshold(threshold);
+  UT_ASSERT(all(P == A));
+
+  // In-place transpose of square, rectangular, column-major and strided matrices:
+  Matrix<double> B = A.copy(false), E = A.copy(), D = E.sub(2, 2, 20, 20);
+  Matrix<double> Ds = D.copy(), Ac = A.copy();
+  Ac.transpose(); B.transpose(); D.transpose();
+  UT_ASSERT_EQUAL(Ac.rows(), size_t(53)); UT_ASSERT_EQUAL(Ac.cols(), size_t(37));
+  UT_ASSERT(Ac.isRowMajor()); UT_ASSERT(! B.isRowMajor());
+  UT_ASSERT(all(Ac == A.t())); UT_ASSERT(all(B == A.t())); UT_ASSERT(all(D == Ds.t()));
+  UT_ASSERT_THROW(A.sub(0, 0, 10, 20).transpose(), ShapeError);
+}
+
+void
+MatrixTest::testRandom()
+{
+  // Reproducible for a seed, independent of the number of threads and the shape:
+  Matrix<double> A = Matrix<double>::rand(123, 77, 42);
+  size_t threshold = OpenMP::getParallelThreshold();
+  OpenMP::setParallelThreshold(1);
+  Matrix<double> B = Matrix<double>::rand(123, 77, 42);
+  Vector<double> x = Vector<double>::rand(123*77, 42);
+  Matrix<double> S;
+  {
+    // The serial NUMA policy initializes single-threaded, with the same numbers:
+    NUMA::Scope scope(NUMA::SERIAL);
+    S = Matrix<double>::rand(123, 77, 42);
+  }
+  OpenMP::setParallelThreshold(threshold);
+  UT_ASSERT(all(A == B)); UT_ASSERT(all(A == S));
+  for (size_t i=0; i<123; i++) {
+    for (size_t j=0; j<77; j++) {
+      UT_ASSERT_EQUAL(A(i,j), x(i*77+j));
+    }
+  }
+
+  // Known-answer tests of Philox4x32-10 (Random123 kat_vectors), counter words 2 and 3 are the
+  // stream, the key is the seed:
+  uint32_t r[4];
+  Philox(0, 0)(0, r);
+  UT_ASSERT_EQUAL(r[0], uint32_t(0x6627e8d5)); UT_ASSERT_EQUAL(r[1], uint32_t(0xe169c58d));
+  UT_ASSERT_EQUAL(r[2], uint32_t(0xbc57ac4c)); UT_ASSERT_EQUAL(r[3], uint32_t(0x9b00dbd8));
+  Philox(0xffffffffffffffffULL, 0xffffffffffffffffULL)(0xffffffffffffffffULL, r);
+  UT_ASSERT_EQUAL(r[0], uint32_t(0x408f276d)); UT_ASSERT_EQUAL(r[1], uint32_t(0x41c83b0e));
+  UT_ASSERT_EQUAL(r[2], uint32_t(0xa20bc7c6)); UT_ASSERT_EQUAL(r[3], uint32_t(0x6d5451fd));
+
+  // Subsequent draws differ, the sequence is reproducible after seeding:
+  Random::seed(7);
+  Matrix<double> C = Matrix<double>::rand(10, 10), D = Matrix<double>::rand(10, 10);
+  Random::seed(7);
+  Matrix<double> E = Matrix<double>::rand(10, 10);
+  UT_ASSERT(all(C == E)); UT_ASSERT(! all(C == D));
+
+  // Moments of the distributions:
+  Vector<double> u = Vector<double>::rand(100000, 1), n = Vector<double>::randn(100000, 1);
+  double su = 0, sn = 0, sn2 = 0;
+  for (size_t i=0; i<u.dim(); i++) {
+    UT_ASSERT((0 <= u(i)) && (u(i) < 1));
+    su += u(i); sn += n(i); sn2 += n(i)*n(i);
+  }
+  UT_ASSERT(std::abs(su/u.dim() - 0.5) < 0.01);
+  UT_ASSERT(std::abs(sn/n.dim()) < 0.02);
+  UT_ASSERT(std::abs(sn2/n.dim() - 1.0) < 0.02);
+}
+
 UnitTest::TestSuite *
 MatrixTest::suite()
 {
@@ -157,5 +506,29 @@ MatrixTest::suite()
   s->addTest(new UnitTest::TestCaller<MatrixTest>(
                "double[m,n]::swap(double[n,m])", &MatrixTest::testSwap));
 
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] memory alignment", &MatrixTest::testAlignment));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] move semantics", &MatrixTest::testMove));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] non-owning views", &MatrixTest::testView));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n]::zeros() NUMA placement", &MatrixTest::testNUMA));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] copy-on-write", &MatrixTest::testCopyOnWrite));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] expression templates", &MatrixTest::testExpression));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n] blocked and in-place transpose", &MatrixTest::testTranspose));
+
+  s->addTest(new UnitTest::TestCaller<MatrixTest>(
+               "double[m,n]::rand() counter-based random numbers", &MatrixTest::testRandom));
+
   return s;
 }
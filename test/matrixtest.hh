@@ -22,6 +22,14 @@ public:
   void testColSelRowMajor();
   void testColSelColMajor();
   void testSwap();
+  void testAlignment();
+  void testMove();
+  void testView();
+  void testNUMA();
+  void testCopyOnWrite();
+  void testExpression();
+  void testTranspose();
+  void testRandom();
 
 public:
   static UnitTest::TestSuite *suite();
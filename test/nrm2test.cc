@@ -5,6 +5,8 @@
 #include "blas/nrm2.hh"
 
 #include <cmath>
+#include <limits>
+#include <complex>
 
 using namespace Linalg;
 
@@ -151,6 +153,82 @@ NRM2Test::testMatrixRowColMajor()
 }
 
 
+void
+NRM2Test::testScaled()
+{
+  // Squares overflow, underflow or are subnormal (dense and strided):
+  double values[] = {1e200, 1e-200, 1e-160, 3e-310};
+  for (size_t k=0; k<4; k++) {
+    Vector<double> x = Vector<double>::empty(37);
+    for (size_t i=0; i<37; i++) { x(i) = (i % 3) ? values[k] : -values[k]; }
+    double ref = values[k]*std::sqrt(37.);
+    UT_ASSERT(std::abs(Blas::nrm2(x) - ref) <= 4e-16*ref);
+
+    Matrix<double> A = Matrix<double>::empty(37, 3);
+    for (size_t i=0; i<37; i++) { A(i,0) = 1; A(i,1) = x(i); A(i,2) = 1; }
+    UT_ASSERT(std::abs(Blas::nrm2(A.col(1)) - ref) <= 4e-16*ref);
+  }
+
+  // Mixed magnitudes, the small elements do not contribute:
+  Vector<double> x = Vector<double>::empty(300);
+  for (size_t i=0; i<300; i++) { x(i) = 1e-300; }
+  x(7) = 3e300; x(211) = -4e300;
+  UT_ASSERT(std::abs(Blas::nrm2(x) - 5e300) <= 4e-16*5e300);
+  UT_ASSERT(std::abs(Blas::nrm2(x.sub(1, 150)) - 3e300) <= 4e-16*3e300);
+
+  // Chunks with different scales, in both orders:
+  Vector<double> z = Vector<double>::empty(1100);
+  for (size_t i=0; i<1100; i++) { z(i) = (i < 600) ? 1e200 : 3e200; }
+  double zref = 1e200*std::sqrt(600. + 9*500.);
+  UT_ASSERT(std::abs(Blas::nrm2(z) - zref) <= 4e-15*zref);
+  for (size_t i=0; i<1100; i++) { z(i) = (i < 600) ? 3e200 : 1e200; }
+  zref = 1e200*std::sqrt(9*600. + 500.);
+  UT_ASSERT(std::abs(Blas::nrm2(z) - zref) <= 4e-15*zref);
+
+  // Single precision:
+  Vector<float> y = Vector<float>::empty(10);
+  for (size_t i=0; i<10; i++) { y(i) = 1e30f; }
+  UT_ASSERT(std::abs(Blas::nrm2(y) - 1e30f*std::sqrt(10.f)) <= 4e-7f*1e30f*std::sqrt(10.f));
+
+  // Zero, infinity and NaN:
+  for (size_t i=0; i<300; i++) { x(i) = 0; }
+  UT_ASSERT_EQUAL(Blas::nrm2(x), 0.0);
+  x(3) = std::numeric_limits<double>::infinity();
+  UT_ASSERT(std::isinf(Blas::nrm2(x)));
+  x(4) = std::numeric_limits<double>::quiet_NaN();
+  UT_ASSERT(std::isnan(Blas::nrm2(x)));
+}
+
+
+void
+NRM2Test::testComplex()
+{
+  typedef std::complex<double> cdouble;
+  Matrix<cdouble> A = Matrix<cdouble>::empty(37, 3);
+  double sq = 0;
+  for (size_t i=0; i<37; i++) {
+    A(i,0) = cdouble(i, 1); A(i,1) = cdouble(3, -2.*i); A(i,2) = cdouble(i, i);
+    sq += 9 + 4.*i*i;
+  }
+  Vector<cdouble> x = A.col(1).copy();
+  UT_ASSERT(std::abs(Blas::nrm2sq(x) - sq) <= 1e-14*sq);
+  UT_ASSERT(std::abs(Blas::nrm2sq(A.col(1)) - sq) <= 1e-14*sq);
+  UT_ASSERT(std::abs(Blas::nrm2(x) - std::sqrt(sq)) <= 1e-14*std::sqrt(sq));
+  UT_ASSERT(std::abs(Blas::nrm2(A.col(1)) - std::sqrt(sq)) <= 1e-14*std::sqrt(sq));
+
+  // Scaled fallback, dense and strided:
+  for (size_t i=0; i<37; i++) { A(i,1) = cdouble(3e200, -4e200); }
+  x = A.col(1).copy();
+  double ref = 5e200*std::sqrt(37.);
+  UT_ASSERT(std::abs(Blas::nrm2(x) - ref) <= 4e-15*ref);
+  UT_ASSERT(std::abs(Blas::nrm2(A.col(1)) - ref) <= 4e-15*ref);
+
+  Vector< std::complex<float> > y = Vector< std::complex<float> >::empty(10);
+  for (size_t i=0; i<10; i++) { y(i) = std::complex<float>(3e-30f, 4e-30f); }
+  UT_ASSERT(std::abs(Blas::nrm2(y) - 5e-30f*std::sqrt(10.f)) <= 4e-6f*5e-30f*std::sqrt(10.f));
+}
+
+
 
 /*
  * Construct TestSuite:
@@ -175,5 +253,11 @@ NRM2Test::suite()
   s->addTest(new UnitTest::TestCaller<NRM2Test>(
                "Blas::nrm2(double[m,m]::row(i) (col-major))", &NRM2Test::testMatrixRowColMajor));
 
+  s->addTest(new UnitTest::TestCaller<NRM2Test>(
+               "Blas::nrm2() without overflow/underflow", &NRM2Test::testScaled));
+
+  s->addTest(new UnitTest::TestCaller<NRM2Test>(
+               "Blas::nrm2(complex[m])", &NRM2Test::testComplex));
+
   return s;
 }
@@ -23,6 +23,8 @@ public:
   void testMatrixColumnColMajor();
   void testMatrixRowRowMajor();
   void testMatrixRowColMajor();
+  void testScaled();
+  void testComplex();
 
 public:
   static UnitTest::TestSuite *suite();
@@ -0,0 +1,88 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+/*
+ * Measures the memory bandwidth of a parallel, row-partitioned update loop on matrices
+ * initialized with the different NUMA placement policies.
+ *
+ * Usage: linalg-bench [N] [repeats]
+ */
+
+#include "matrix.hh"
+#include "numa.hh"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstdlib>
+
+using namespace Linalg;
+
+
+/* Runs A = 2*A + 1 with the same static row partition the initialization uses and returns the
+ * achieved bandwidth in GB/s. */
+static double
+__bench_update(Matrix<double> &A, size_t repeats)
+{
+  size_t rows = A.rows(), cols = A.cols(), ld = A.strides(0);
+  double *ptr = A.ptr();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t r=0; r<repeats; r++) {
+#pragma omp parallel for schedule(static)
+    for (size_t i=0; i<rows; i++) {
+      double *row = ptr + i*ld;
+      for (size_t j=0; j<cols; j++) { row[j] = 2*row[j] + 1; }
+    }
+  }
+  double dt = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+  // Each element is read and written once per repeat:
+  return 2.*sizeof(double)*rows*cols*repeats/dt/1e9;
+}
+
+
+static void
+__bench_policy(const char *name, NUMA::Policy policy, size_t N, size_t repeats)
+{
+  NUMA::Scope scope(policy);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Matrix<double> A = Matrix<double>::zeros(N, N);
+  double dt = std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+  double bw = __bench_update(A, repeats);
+  std::cout << std::setw(12) << name
+            << std::setw(12) << std::fixed << std::setprecision(3) << dt
+            << std::setw(12) << std::setprecision(2) << bw << std::endl;
+}
+
+
+int main(int argc, char *argv[])
+{
+  size_t N       = (argc > 1) ? std::atoi(argv[1]) : 4096;
+  size_t repeats = (argc > 2) ? std::atoi(argv[2]) : 10;
+
+  std::cout << "Matrix " << N << "x" << N << " (" << (N*N*sizeof(double))/(1<<20) << " MB), "
+            << repeats << " repeats, " << OpenMP::getMaxThreads() << " threads";
+#ifndef LINALG_HAS_OPENMP
+  std::cout << " (OpenMP disabled, all policies are serial)";
+#endif
+  std::cout << std::endl;
+  std::cout << "NUMA: " << (NUMA::available() ? "libnuma available" : "no libnuma") << std::endl;
+  std::cout << std::setw(12) << "policy" << std::setw(12) << "init [s]"
+            << std::setw(12) << "BW [GB/s]" << std::endl;
+
+  __bench_policy("serial", NUMA::SERIAL, N, repeats);
+  __bench_policy("first-touch", NUMA::FIRST_TOUCH, N, repeats);
+  if (NUMA::available()) {
+    __bench_policy("interleave", NUMA::INTERLEAVE, N, repeats);
+    __bench_policy("bind(0)", NUMA::BIND, N, repeats);
+  }
+
+  return 0;
+}
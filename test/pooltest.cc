@@ -0,0 +1,196 @@
+#include "pooltest.hh"
+
+#include "pool.hh"
+#include "matrix.hh"
+#include "workspace.hh"
+#include "memstats.hh"
+#include "operators.hh"
+#include <sstream>
+#include <vector>
+
+using namespace Linalg;
+
+
+void
+PoolTest::testSizeClasses()
+{
+  UT_ASSERT_EQUAL((int)MemoryPool::sizeClass(1), 0);
+  UT_ASSERT_EQUAL((int)MemoryPool::sizeClass(LINALG_ALIGNMENT), 0);
+  UT_ASSERT_EQUAL((int)MemoryPool::sizeClass(LINALG_ALIGNMENT+1), 1);
+  UT_ASSERT_EQUAL((int)MemoryPool::sizeClass(4*LINALG_ALIGNMENT), 2);
+  UT_ASSERT(MemoryPool::classSize(MemoryPool::sizeClass(1000)) >= 1000);
+  UT_ASSERT_EQUAL(MemoryPool::sizeClass(size_t(1) << 40), MemoryPool::num_classes);
+}
+
+
+void
+PoolTest::testReuse()
+{
+  MemoryPool::trim();
+  MemoryPool::resetStats();
+
+  void *a = MemoryPool::alloc(1000);
+  UT_ASSERT(__is_aligned(a));
+  MemoryPool::free(a, 1000);
+
+  // Same size class -> same block
+  void *b = MemoryPool::alloc(900);
+  UT_ASSERT(a == b);
+  MemoryPool::free(b, 900);
+
+  PoolStats stats = MemoryPool::stats();
+  UT_ASSERT_EQUAL(stats.misses, size_t(1));
+  UT_ASSERT_EQUAL(stats.hits, size_t(1));
+  UT_ASSERT_EQUAL(stats.recycled, size_t(2));
+
+  MemoryPool::trim();
+  UT_ASSERT_EQUAL(MemoryPool::cached(), size_t(0));
+}
+
+
+void
+PoolTest::testTemporaries()
+{
+  MemoryPool::resetStats();
+
+  Matrix<double> A = Matrix<double>::rand(10, 10);
+  for (size_t i=0; i<100; i++) {
+    Matrix<double> B = A.copy();
+  }
+
+  // All but the first copy are served from the cache:
+  UT_ASSERT(MemoryPool::stats().hits >= 99);
+}
+
+
+void
+PoolTest::testScope()
+{
+  MemoryPool::trim();
+
+  // Blocks of the largest size class (more than half a block, as the data manager is allocated
+  // in the same block), together more than the cache may hold outside of a scope:
+  size_t block = MemoryPool::classSize(MemoryPool::num_classes-1);
+  size_t n = LINALG_POOL_MAX_CACHED/block + 2, rows = block/(2*sizeof(double)) + 64;
+  {
+    MemoryPool::Scope scope;
+    {
+      std::vector< Matrix<double> > A;
+      for (size_t i=0; i<n; i++) { A.push_back(Matrix<double>(rows, 1)); }
+    }
+    // Retained within the scope:
+    UT_ASSERT(MemoryPool::cached() > LINALG_POOL_MAX_CACHED);
+  }
+  // Trimmed on exit of scope
+  UT_ASSERT(MemoryPool::cached() <= LINALG_POOL_MAX_CACHED);
+  UT_ASSERT(MemoryPool::cached() > 0);
+  MemoryPool::trim();
+}
+
+
+void
+PoolTest::testWorkspace()
+{
+  Workspace ws;
+
+  {
+    Workspace::Frame outer(ws);
+    double *a = outer.alloc<double>(3);
+    UT_ASSERT(__is_aligned(a));
+    size_t used = ws.used();
+
+    {
+      Workspace::Frame inner(ws);
+      double *b = inner.alloc<double>(5);
+      UT_ASSERT(__is_aligned(b));
+      UT_ASSERT(b >= a+3);
+      // Larger than a chunk:
+      double *c = inner.alloc<double>(LINALG_WORKSPACE_CHUNK_SIZE);
+      UT_ASSERT(__is_aligned(c));
+      UT_ASSERT_EQUAL(ws.depth(), size_t(2));
+    }
+
+    // Inner frame released:
+    UT_ASSERT_EQUAL(ws.used(), used);
+    UT_ASSERT(ws.highWaterMark() > LINALG_WORKSPACE_CHUNK_SIZE*sizeof(double));
+  }
+  UT_ASSERT_EQUAL(ws.used(), size_t(0));
+
+  // Chunks are reused:
+  size_t capacity = ws.capacity();
+  {
+    Workspace::Frame frame(ws);
+    frame.alloc<double>(3);
+    frame.alloc<double>(LINALG_WORKSPACE_CHUNK_SIZE);
+  }
+  UT_ASSERT_EQUAL(ws.capacity(), capacity);
+}
+
+
+void
+PoolTest::testMemStats()
+{
+  if (! MemStats::enabled()) {
+    // Accounting disabled: everything is zero.
+    Matrix<double> A(10,10);
+    UT_ASSERT_EQUAL(MemStats::live(), size_t(0));
+    UT_ASSERT_EQUAL(MemStats::count(), size_t(0));
+    return;
+  }
+
+  MemStats::reset();
+  size_t live = MemStats::live();
+  MemStats::Scope scope;
+  {
+    Matrix<double> A = Matrix<double>::rand(10,20);
+    UT_ASSERT_EQUAL(MemStats::live(), live + 10*20*sizeof(double));
+    {
+      LINALG_MEMSTATS_TAG("testMemStats");
+      Matrix<double> B(100,100);
+    }
+    Matrix<double> C = A.t() * A;
+    UT_ASSERT_EQUAL(MemStats::entry("operator*(Matrix,Matrix)").count, size_t(1));
+  }
+
+  // All released:
+  UT_ASSERT_EQUAL(MemStats::live(), live);
+  UT_ASSERT_EQUAL(scope.count(), size_t(3));
+  UT_ASSERT_EQUAL(scope.peak(), (200+10000)*sizeof(double));
+  UT_ASSERT_EQUAL(MemStats::largest(), 10000*sizeof(double));
+
+  MemStatsEntry e = MemStats::entry("testMemStats");
+  UT_ASSERT_EQUAL(e.count, size_t(1));
+  UT_ASSERT_EQUAL(e.live, size_t(0));
+  UT_ASSERT_EQUAL(e.peak, 10000*sizeof(double));
+
+  std::stringstream buffer;
+  MemStats::dump(buffer);
+  UT_ASSERT(std::string::npos != buffer.str().find("testMemStats"));
+}
+
+
+UnitTest::TestSuite *
+PoolTest::suite()
+{
+  UnitTest::TestSuite *s = new UnitTest::TestSuite("Tests for MemoryPool");
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "MemoryPool size classes", &PoolTest::testSizeClasses));
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "MemoryPool block reuse", &PoolTest::testReuse));
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "double[m,n]::copy() temporaries", &PoolTest::testTemporaries));
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "MemoryPool::Scope", &PoolTest::testScope));
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "Workspace frames", &PoolTest::testWorkspace));
+
+  s->addTest(new UnitTest::TestCaller<PoolTest>(
+               "MemStats accounting", &PoolTest::testMemStats));
+
+  return s;
+}
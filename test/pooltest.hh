@@ -0,0 +1,29 @@
+/*
+ * This file is part of the Linalg project, a C++ interface to BLAS and LAPACK.
+ *
+ * The source-code is licensed under the terms of the MIT license, read LICENSE for more details.
+ *
+ * (c) 2011, 2012 Hannes Matuschek <hmatuschek at gmail dot com>
+ */
+
+#ifndef POOLTEST_HH
+#define POOLTEST_HH
+
+#include "unittest.hh"
+
+
+class PoolTest : public UnitTest::TestCase
+{
+public:
+  void testSizeClasses();
+  void testReuse();
+  void testTemporaries();
+  void testScope();
+  void testWorkspace();
+  void testMemStats();
+
+public:
+  static UnitTest::TestSuite *suite();
+};
+
+#endif // POOLTEST_HH
@@ -3,6 +3,10 @@
 #include <sstream>
 #include <limits>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <unistd.h>
 #include "cputime.hh"
 
 using namespace UnitTest;
@@ -32,6 +36,38 @@ TestFailure::what() const throw ()
 
 
 
+/* ********************************************************************************************* *
+ * Implementation of TempFile
+ * ********************************************************************************************* */
+TempFile::TempFile()
+{
+  const char *dir = getenv("TMPDIR");
+  std::string pattern = std::string(((0 != dir) && (0 != *dir)) ? dir : "/tmp")
+      + "/linalg-test-XXXXXX";
+  std::vector<char> buffer(pattern.begin(), pattern.end()); buffer.push_back(0);
+
+  int fd = mkstemp(&buffer[0]);
+  if (0 > fd) {
+    throw TestFailure("Can not create temporary file " + pattern + ".");
+  }
+  close(fd);
+  this->filename = &buffer[0];
+}
+
+TempFile::~TempFile()
+{
+  std::remove(this->filename.c_str());
+}
+
+const std::string &
+TempFile::name() const
+{
+  return this->filename;
+}
+
+
+
+
 /* ********************************************************************************************* *
  * Implementation of TestCase
  * ********************************************************************************************* */
@@ -32,6 +32,25 @@ public:
 
 
 
+/** Creates a unique, empty temporary file, that is removed again on destruction. */
+class TempFile
+{
+protected:
+  std::string filename;
+
+public:
+  TempFile();
+  virtual ~TempFile();
+
+  const std::string &name() const;
+
+private:
+  TempFile(const TempFile &other);
+  TempFile &operator= (const TempFile &other);
+};
+
+
+
 class TestCase
 {
 public: